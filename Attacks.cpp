@@ -0,0 +1,175 @@
+#include "Headers/Attacks.h"
+#include "Headers/Bitboard.h"
+#include "Headers/Cpu.h"
+#include "Headers/EvalTrace.h"
+
+// The kernels are templates on the CpuLevel, inlined into one wrapper per level (at the end) : the target
+// of the wrapper decides what __builtin_popcountll and __builtin_ctzll become, and BMI2 looks the sliders up
+// (bishopAttacksOf / rookAttacksOf, in Cpu.h)
+
+template <CpuLevel level>
+KERNEL void computeAttackMapsKernel(const uint64_t* bitboards, AttackMaps& maps) {
+    uint64_t occupied = 0;
+    for (int i = 0; i < 12; ++i)
+        occupied |= bitboards[i];
+
+    for (int side = 0; side < 2; ++side) {
+        const uint64_t* pieces = bitboards + side * 6;
+        uint64_t* attacks = maps.byPiece + side * 6;
+
+        attacks[0] = side == 0 ? whitePawnAttacks(pieces[0]) : blackPawnAttacks(pieces[0]);
+        attacks[1] = knightAttacks(pieces[1]);
+        attacks[2] = bishopAttacksOf<level>(pieces[2], occupied);
+        attacks[3] = rookAttacksOf<level>(pieces[3], occupied);
+        attacks[4] = bishopAttacksOf<level>(pieces[4], occupied) | rookAttacksOf<level>(pieces[4], occupied);
+        attacks[5] = kingAttacks(pieces[5]);
+
+        maps.bySide[side] = attacks[0] | attacks[1] | attacks[2] | attacks[3] | attacks[4] | attacks[5];
+    }
+}
+
+// The square seen as a piece of each kind : does it reach a piece of this kind of the side ?
+template <CpuLevel level>
+KERNEL bool isSquareAttackedKernel(const uint64_t* bitboards, int square, int side) {
+    const uint64_t* pieces = bitboards + side * 6;
+    uint64_t target = 1ULL << square;
+
+    if ((knightAttacks(target) & pieces[1]) || (kingAttacks(target) & pieces[5]))
+        return true;
+    if ((side == 0 ? blackPawnAttacks(target) : whitePawnAttacks(target)) & pieces[0])
+        return true;
+
+    uint64_t diagonal = pieces[2] | pieces[4];
+    uint64_t straight = pieces[3] | pieces[4];
+    uint64_t occupied = 0;
+    for (int i = 0; i < 12; ++i)
+        occupied |= bitboards[i];
+
+    return (diagonal && (bishopAttacksOf<level>(target, occupied) & diagonal)) ||
+           (straight && (rookAttacksOf<level>(target, occupied) & straight));
+}
+
+template <CpuLevel level>
+KERNEL void evaluateAttacksKernel(const uint64_t* bitboards, const AttackMaps& maps, int& mg, int& eg, EvalTrace* trace) {
+    mg = 0;
+    eg = 0;
+
+    for (int side = 0; side < 2; ++side) {
+        int us = side * 6;
+        int them = (1 - side) * 6;
+        int sign = side == 0 ? 1 : -1;
+
+        uint64_t own = 0;
+        for (int i = 0; i < 6; ++i)
+            own |= bitboards[us + i];
+
+        // Mobility : squares not taken by our pieces nor attacked by their pawns
+        uint64_t safe = ~own & ~maps.byPiece[them];
+        for (int type = 1; type <= 4; ++type) {
+            int count = __builtin_popcountll(maps.byPiece[us + type] & safe);
+            mg += sign * MOBILITY_MG[type] * count;
+            eg += sign * MOBILITY_EG[type] * count;
+            if (trace)
+                trace->add(PARAM_MOBILITY + type, sign * count);
+        }
+
+        // Attacks around the enemy king
+        uint64_t kingZone = bitboards[them + 5] | kingAttacks(bitboards[them + 5]);
+        for (int type = 1; type <= 4; ++type) {
+            int count = __builtin_popcountll(maps.byPiece[us + type] & kingZone);
+            mg += sign * KING_ZONE_ATTACK[type] * count;
+            if (trace)
+                trace->add(PARAM_KING_ZONE_ATTACK + type, sign * count);
+        }
+
+        // Our pieces (without pawns and king) left en prise
+        uint64_t pieces = own & ~bitboards[us] & ~bitboards[us + 5];
+        int hanging = __builtin_popcountll(pieces & maps.bySide[1 - side] & ~maps.bySide[side]);
+        int pawnThreats = __builtin_popcountll(pieces & maps.byPiece[them]);
+        mg += sign * (HANGING_PIECE_MG * hanging + PAWN_THREAT_MG * pawnThreats);
+        eg += sign * (HANGING_PIECE_EG * hanging + PAWN_THREAT_EG * pawnThreats);
+        if (trace) {
+            trace->add(PARAM_HANGING_PIECE, sign * hanging);
+            trace->add(PARAM_PAWN_THREAT, sign * pawnThreats);
+        }
+    }
+}
+
+
+// One version per CpuLevel, chosen at each call by cpuLevel
+
+static void computeAttackMapsGeneric(const uint64_t* bitboards, AttackMaps& maps) {
+    computeAttackMapsKernel<CPU_GENERIC>(bitboards, maps);
+}
+
+static void evaluateAttacksGeneric(const uint64_t* bitboards, const AttackMaps& maps, int& mg, int& eg, EvalTrace* trace) {
+    evaluateAttacksKernel<CPU_GENERIC>(bitboards, maps, mg, eg, trace);
+}
+
+static bool isSquareAttackedGeneric(const uint64_t* bitboards, int square, int side) {
+    return isSquareAttackedKernel<CPU_GENERIC>(bitboards, square, side);
+}
+
+#ifdef CPU_X86_64
+
+__attribute__((target("popcnt")))
+static void computeAttackMapsPopcnt(const uint64_t* bitboards, AttackMaps& maps) {
+    computeAttackMapsKernel<CPU_POPCNT>(bitboards, maps);
+}
+
+__attribute__((target("popcnt")))
+static void evaluateAttacksPopcnt(const uint64_t* bitboards, const AttackMaps& maps, int& mg, int& eg, EvalTrace* trace) {
+    evaluateAttacksKernel<CPU_POPCNT>(bitboards, maps, mg, eg, trace);
+}
+
+__attribute__((target("popcnt")))
+static bool isSquareAttackedPopcnt(const uint64_t* bitboards, int square, int side) {
+    return isSquareAttackedKernel<CPU_POPCNT>(bitboards, square, side);
+}
+
+__attribute__((target("popcnt,bmi,bmi2")))
+static void computeAttackMapsBmi2(const uint64_t* bitboards, AttackMaps& maps) {
+    computeAttackMapsKernel<CPU_BMI2>(bitboards, maps);
+}
+
+__attribute__((target("popcnt,bmi,bmi2")))
+static void evaluateAttacksBmi2(const uint64_t* bitboards, const AttackMaps& maps, int& mg, int& eg, EvalTrace* trace) {
+    evaluateAttacksKernel<CPU_BMI2>(bitboards, maps, mg, eg, trace);
+}
+
+__attribute__((target("popcnt,bmi,bmi2")))
+static bool isSquareAttackedBmi2(const uint64_t* bitboards, int square, int side) {
+    return isSquareAttackedKernel<CPU_BMI2>(bitboards, square, side);
+}
+
+#endif
+
+void computeAttackMaps(const uint64_t* bitboards, AttackMaps& maps) {
+#ifdef CPU_X86_64
+    if (cpuLevel == CPU_BMI2)
+        return computeAttackMapsBmi2(bitboards, maps);
+    if (cpuLevel == CPU_POPCNT)
+        return computeAttackMapsPopcnt(bitboards, maps);
+#endif
+    computeAttackMapsGeneric(bitboards, maps);
+}
+
+void evaluateAttacks(const uint64_t* bitboards, const AttackMaps& maps, int& mg, int& eg, EvalTrace* trace) {
+#ifdef CPU_X86_64
+    if (cpuLevel == CPU_BMI2)
+        return evaluateAttacksBmi2(bitboards, maps, mg, eg, trace);
+    if (cpuLevel == CPU_POPCNT)
+        return evaluateAttacksPopcnt(bitboards, maps, mg, eg, trace);
+#endif
+    evaluateAttacksGeneric(bitboards, maps, mg, eg, trace);
+}
+
+bool isSquareAttacked(const uint64_t* bitboards, int square, int side) {
+#ifdef CPU_X86_64
+    if (cpuLevel == CPU_BMI2)
+        return isSquareAttackedBmi2(bitboards, square, side);
+    if (cpuLevel == CPU_POPCNT)
+        return isSquareAttackedPopcnt(bitboards, square, side);
+#endif
+    return isSquareAttackedGeneric(bitboards, square, side);
+}
@@ -0,0 +1,121 @@
+#include "Headers/Benchmark.h"
+#include "Headers/chessboard.h"
+#include "Headers/Cpu.h"
+#include "Headers/Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+struct BenchPosition {
+    const char* fen;
+    int perftDepth;
+};
+
+// Start position, then castling, en passant and promotions
+static const BenchPosition POSITIONS[] = {
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 4},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 3},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 3}
+};
+constexpr int POSITION_COUNT = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+constexpr int BENCH_RUNS = 3;
+
+struct BenchResult {
+    uint64_t perftNodes[POSITION_COUNT];
+    int scores[POSITION_COUNT];
+    long searchNodes = 0;
+    double perftSeconds = 0;
+    double searchSeconds = 0;
+    ProfileCounters profile; // Of the searches, built with -DPROFILE_ZONES
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static BenchResult runOnce(ChessBoard& board, int searchDepth) {
+    BenchResult result;
+    bool whiteToMove;
+
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        board.loadFen(POSITIONS[i].fen, whiteToMove);
+        auto start = std::chrono::steady_clock::now();
+        result.perftNodes[i] = board.perft(POSITIONS[i].perftDepth, whiteToMove);
+        result.perftSeconds += secondsSince(start);
+    }
+
+#ifdef PROFILE_ZONES
+    profileCounters = ProfileCounters();
+#endif
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        board.loadFen(POSITIONS[i].fen, whiteToMove);
+        board.clearSearchTables();
+        board.stats = SearchStats();
+        auto start = std::chrono::steady_clock::now();
+        {
+            PROFILE_ZONE(ZONE_SEARCH);
+            result.scores[i] = board.alphaBeta<ROOT>(searchDepth, whiteToMove, -INFINITE_SCORE, INFINITE_SCORE);
+        }
+        result.searchSeconds += secondsSince(start);
+        result.searchNodes += board.stats.nodes;
+    }
+#ifdef PROFILE_ZONES
+    result.profile = profileCounters;
+#endif
+    board.stats = SearchStats();
+    return result;
+}
+
+// The times are noisy : each way runs several times, one after the other, and keeps its best times
+static void keepBest(BenchResult& best, const BenchResult& run, bool first) {
+    if (first) {
+        best = run;
+        return;
+    }
+    best.perftSeconds = std::min(best.perftSeconds, run.perftSeconds);
+    if (run.searchSeconds < best.searchSeconds) {
+        best.searchSeconds = run.searchSeconds;
+        best.profile = run.profile;
+    }
+}
+
+bool runBenchmark(ChessBoard& board, int searchDepth) {
+    bool copyMake = board.copyMake;
+    BenchResult unmake, copy;
+
+    for (int run = 0; run < BENCH_RUNS; ++run) {
+        board.copyMake = false;
+        keepBest(unmake, runOnce(board, searchDepth), run == 0);
+        board.copyMake = true;
+        keepBest(copy, runOnce(board, searchDepth), run == 0);
+    }
+    board.copyMake = copyMake;
+
+    bool same = true;
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        if (unmake.perftNodes[i] != copy.perftNodes[i] || unmake.scores[i] != copy.scores[i]) {
+            std::cerr << "Different results for " << POSITIONS[i].fen << std::endl;
+            same = false;
+        }
+    }
+    same = same && unmake.searchNodes == copy.searchNodes;
+
+    uint64_t perftNodes = 0;
+    for (int i = 0; i < POSITION_COUNT; ++i)
+        perftNodes += unmake.perftNodes[i];
+
+    std::cout << "CPU : " << cpuLevelName(cpuLevel) << " (supported : " << cpuLevelName(cpuSupportedLevel()) << ")" << std::endl;
+    std::cout << "Position : " << sizeof(Position) << " bytes" << std::endl;
+    std::cout << "Perft : " << perftNodes << " nodes, make/unmake " << unmake.perftSeconds
+              << " s, copy-make " << copy.perftSeconds << " s" << std::endl;
+    std::cout << "Search : depth " << searchDepth << ", " << unmake.searchNodes << " nodes, make/unmake "
+              << unmake.searchSeconds << " s, copy-make " << copy.searchSeconds << " s" << std::endl;
+#ifdef PROFILE_ZONES
+    std::cout << "Search profile, make/unmake (best run) :" << std::endl << profileReport(unmake.profile);
+    std::cout << "Search profile, copy-make (best run) :" << std::endl << profileReport(copy.profile);
+#endif
+    std::cout << (same ? "Same nodes and scores" : "The results are different") << std::endl;
+    return same;
+}
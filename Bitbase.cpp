@@ -0,0 +1,39 @@
+#include "Headers/Bitbase.h"
+#include <cstring>
+#include <iostream>
+
+bool Bitbases::openTable(MappedFile& file, const std::string& path, const char* magic, size_t dataSize, int table) {
+    if (!file.open(path))
+        return false;
+
+    bool valid = file.size() == BITBASE_HEADER_SIZE + dataSize;
+    if (valid) {
+        const unsigned char* header = file.bytes();
+        uint32_t version, id, pieceCount;
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&id, header + 8, 4);
+        std::memcpy(&pieceCount, header + 12, 4);
+        valid = std::memcmp(header, magic, 4) == 0 && version == BITBASE_VERSION &&
+                id == static_cast<uint32_t>(table) && pieceCount == static_cast<uint32_t>(BITBASE_INFO[table].pieceCount);
+    }
+
+    if (!valid) {
+        std::cerr << "Bitbase: " << path << " is not a valid table, generate it again" << std::endl;
+        file.close();
+    }
+    return valid;
+}
+
+bool Bitbases::load(const std::string& directory) {
+    bool found = false;
+
+    for (int table = 0; table < BITBASE_COUNT; ++table) {
+        std::string path = directory + "/" + BITBASE_INFO[table].name;
+        if (!openTable(files[table], path + ".bb", "CBBS", bitbaseSize(table) / 8, table))
+            continue;
+        found = true;
+        openTable(distanceFiles[table], path + ".dtm", "CDTM", bitbaseSize(table), table);
+    }
+
+    return found;
+}
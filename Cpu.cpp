@@ -0,0 +1,74 @@
+#include "Headers/Cpu.h"
+#include "Headers/Bitboard.h"
+
+static CpuLevel supportedLevel = CPU_GENERIC;
+
+#ifdef CPU_X86_64
+
+PextTable ROOK_PEXT;
+PextTable BISHOP_PEXT;
+uint64_t PEXT_ATTACKS[PEXT_ATTACKS_SIZE];
+
+// The subsets of the mask come in the order of their PEXT index (carry-rippler), the attacks
+// themselves are computed by the Kogge-Stone fills
+static void buildPextTable(PextTable& table, uint32_t& offset, bool rook) {
+    for (int square = 0; square < 64; ++square) {
+        uint64_t from = 1ULL << square;
+        uint64_t edges = (0xFF000000000000FFULL & ~(0xFFULL << (square & 56))) | ((FILE_A | FILE_H) & ~(FILE_A << (square & 7)));
+        uint64_t rays = rook ? rookAttacks(from, ~0ULL) : bishopAttacks(from, ~0ULL);
+
+        table.mask[square] = rays & ~edges;
+        table.offset[square] = offset;
+
+        uint64_t subset = 0;
+        do {
+            PEXT_ATTACKS[offset++] = rook ? rookAttacks(from, ~subset) : bishopAttacks(from, ~subset);
+            subset = (subset - table.mask[square]) & table.mask[square];
+        } while (subset);
+    }
+}
+
+// AMD before Zen 3 (Excavator, Zen 1 and 2) runs PEXT in microcode, tens of cycles depending on the mask :
+// the Kogge-Stone fills of the popcnt level are faster there
+static bool hasSlowPext() {
+    return __builtin_cpu_is("amd") && (__builtin_cpu_is("amdfam15h") || __builtin_cpu_is("amdfam17h"));
+}
+
+#endif
+
+// The level in use at startup : the best one, except BMI2 where PEXT is slow (it can still be forced)
+static CpuLevel startCpu() {
+#ifdef CPU_X86_64
+    __builtin_cpu_init(); // Before main : the CPU model may not be read yet
+    if (__builtin_cpu_supports("popcnt"))
+        supportedLevel = CPU_POPCNT;
+    if (supportedLevel == CPU_POPCNT && __builtin_cpu_supports("bmi") && __builtin_cpu_supports("bmi2")) {
+        uint32_t offset = 0;
+        buildPextTable(ROOK_PEXT, offset, true);
+        buildPextTable(BISHOP_PEXT, offset, false);
+        supportedLevel = CPU_BMI2;
+        if (hasSlowPext())
+            return CPU_POPCNT;
+    }
+#endif
+    return supportedLevel;
+}
+
+// Generic until the static initialisation gets here
+CpuLevel cpuLevel = startCpu();
+
+CpuLevel cpuSupportedLevel() {
+    return supportedLevel;
+}
+
+void setCpuLevel(CpuLevel level) {
+    cpuLevel = level < supportedLevel ? level : supportedLevel;
+}
+
+const char* cpuLevelName(CpuLevel level) {
+    switch (level) {
+        case CPU_POPCNT: return "popcnt";
+        case CPU_BMI2: return "bmi2";
+        default: return "generic";
+    }
+}
@@ -0,0 +1,90 @@
+#include "Headers/Endgame.h"
+#include "Headers/Evaluation.h"
+
+// Bitboards indexed by PieceType : side * 6 + PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING
+
+static inline int signFor(int strongSide, int score) {
+    return strongSide == 0 ? score : -score;
+}
+
+int evaluateDraw(const uint64_t* bitboards, int strongSide) {
+    (void)bitboards;
+    (void)strongSide;
+    return 0;
+}
+
+// The material is enough : the weak king goes to the edge and the kings get closer
+int evaluateKXK(const uint64_t* bitboards, int strongSide) {
+    int us = strongSide * 6;
+    int strongKing = __builtin_ctzll(bitboards[us + 5]);
+    int weakKing = __builtin_ctzll(bitboards[6 - us + 5]);
+
+    int result = 0;
+    for (int type = 0; type < 5; ++type)
+        result += EG_VALUE[type] * __builtin_popcountll(bitboards[us + type]);
+
+    // Pawns go to promotion
+    uint64_t pawns = bitboards[us];
+    while (pawns) {
+        int rank = __builtin_ctzll(pawns) >> 3;
+        result += 10 * (strongSide == 0 ? rank : 7 - rank);
+        pawns &= pawns - 1;
+    }
+
+    result += PUSH_TO_EDGE * (3 - edgeDistance(weakKing));
+    result += PUSH_CLOSE * (7 - squareDistance(strongKing, weakKing));
+    return signFor(strongSide, result);
+}
+
+// Same as KXK, but only the two corners of the color of the bishop
+int evaluateKBNK(const uint64_t* bitboards, int strongSide) {
+    int us = strongSide * 6;
+    int strongKing = __builtin_ctzll(bitboards[us + 5]);
+    int weakKing = __builtin_ctzll(bitboards[6 - us + 5]);
+    bool darkBishop = isDarkSquare(__builtin_ctzll(bitboards[us + 2]));
+
+    int result = EG_VALUE[1] + EG_VALUE[2];
+    result += PUSH_TO_CORNER * (7 - bishopCornerDistance(weakKing, darkBishop));
+    result += PUSH_CLOSE * (7 - squareDistance(strongKing, weakKing));
+    return signFor(strongSide, result);
+}
+
+// Won when the strong king stops the pawn or the weak king is too far, close to a draw when the
+// pawn is advanced with its king next to it. Seen from the strong side : the pawn goes to rank 1.
+int evaluateKRKP(const uint64_t* bitboards, int strongSide) {
+    int us = strongSide * 6;
+    int them = 6 - us;
+    int flip = strongSide == 0 ? 0 : 56;
+    int strongKing = __builtin_ctzll(bitboards[us + 5]) ^ flip;
+    int weakKing = __builtin_ctzll(bitboards[them + 5]) ^ flip;
+    int rook = __builtin_ctzll(bitboards[us + 3]) ^ flip;
+    int pawn = __builtin_ctzll(bitboards[them]) ^ flip;
+    int pawnSteps = pawn >> 3; // Moves left to promote
+    int front = pawn - 8;
+
+    int result;
+    if ((strongKing & 7) == (pawn & 7) && strongKing < pawn)
+        result = EG_VALUE[3] - squareDistance(strongKing, pawn);
+    else if (squareDistance(weakKing, pawn) >= 3 && squareDistance(weakKing, rook) >= 3)
+        result = EG_VALUE[3] - squareDistance(strongKing, pawn);
+    else if ((weakKing >> 3) <= 2 && squareDistance(weakKing, pawn) == 1 && (strongKing >> 3) >= 3 &&
+             squareDistance(strongKing, pawn) > 2)
+        result = 80 - 8 * squareDistance(strongKing, pawn);
+    else
+        result = 200 - 8 * (squareDistance(strongKing, front) - squareDistance(weakKing, front) - pawnSteps);
+
+    return signFor(strongSide, result);
+}
+
+// One bishop each : on opposite colors the side ahead needs more than one extra pawn
+int scaleOppositeBishops(const uint64_t* bitboards, int strongSide) {
+    if (isDarkSquare(__builtin_ctzll(bitboards[2])) == isDarkSquare(__builtin_ctzll(bitboards[8])))
+        return SCALE_NORMAL;
+
+    uint64_t otherPieces = bitboards[1] | bitboards[3] | bitboards[4] | bitboards[7] | bitboards[9] | bitboards[10];
+    if (otherPieces)
+        return 48; // The other pieces can still attack
+
+    int extraPawns = __builtin_popcountll(bitboards[strongSide * 6]) - __builtin_popcountll(bitboards[6 - strongSide * 6]);
+    return std::min(SCALE_NORMAL, 16 + 12 * std::max(0, extraPawns - 1));
+}
@@ -0,0 +1,31 @@
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#include <cstdint>
+
+// Bonuses and penalties in centipawns (middlegame, endgame), indexed by PieceType % 6
+constexpr int MOBILITY_MG[6] = {0, 4, 5, 2, 1, 0}; // By square reached
+constexpr int MOBILITY_EG[6] = {0, 4, 5, 4, 2, 0};
+constexpr int KING_ZONE_ATTACK[6] = {0, 8, 8, 10, 15, 0}; // By square of the enemy king zone attacked, middlegame only
+constexpr int HANGING_PIECE_MG = -25; // Attacked and not defended
+constexpr int HANGING_PIECE_EG = -15;
+constexpr int PAWN_THREAT_MG = -30; // Piece attacked by a pawn
+constexpr int PAWN_THREAT_EG = -20;
+
+// All the attacks of a position, computed in one pass for all the pieces of a type
+struct AttackMaps {
+    uint64_t byPiece[12]; // Squares attacked by the pieces of a PieceType
+    uint64_t bySide[2];   // [0] White, [1] Black
+};
+
+struct EvalTrace;
+
+void computeAttackMaps(const uint64_t* bitboards, AttackMaps& maps);
+
+// Attacked by a piece of the side (0 White, 1 Black)
+bool isSquareAttacked(const uint64_t* bitboards, int square, int side);
+
+// Mobility, king zone attacks and hanging pieces : White - Black
+void evaluateAttacks(const uint64_t* bitboards, const AttackMaps& maps, int& mg, int& eg, EvalTrace* trace = nullptr);
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+class ChessBoard;
+
+// Perft and fixed depth searches on a few positions, once with make / unmake and once with copy-make.
+// Both ways must give the same node counts and scores, only the times can differ.
+// Returns false if they don't.
+bool runBenchmark(ChessBoard& board, int searchDepth = 6);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef BITBASE_H
+#define BITBASE_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+
+// Endgames of a king and 1 or 2 pieces against a lone king. The strong side is always White in the
+// tables : Black positions are mirrored. The weak side can never win, 1 bit is enough : strong side wins or not.
+// Optional .dtm tables give the distance to mate (1 byte per position) for a perfect play.
+enum BitbaseTable { KPK, KRK, KQK, KBNK, BITBASE_COUNT };
+
+struct BitbaseInfo {
+    const char* name;
+    int pieceCount;
+    int pieces[2]; // White PieceType of the pieces besides the king
+};
+
+constexpr BitbaseInfo BITBASE_INFO[BITBASE_COUNT] = {
+    {"KPK", 1, {0, -1}},
+    {"KRK", 1, {3, -1}},
+    {"KQK", 1, {4, -1}},
+    {"KBNK", 2, {2, 1}}
+};
+
+constexpr uint32_t BITBASE_VERSION = 1;
+constexpr int BITBASE_HEADER_SIZE = 16; // "CBBS" (or "CDTM"), version, table, piece count
+
+// Side to move, strong king, weak king, then the pieces in the order of BitbaseInfo
+inline uint32_t bitbaseSize(int table) {
+    return 2u << (6 * (2 + BITBASE_INFO[table].pieceCount));
+}
+
+inline uint32_t bitbaseIndex(bool strongToMove, int strongKing, int weakKing, const int* squares, int pieceCount) {
+    uint32_t index = strongToMove ? 0 : 1;
+    index = (index << 6) | strongKing;
+    index = (index << 6) | weakKing;
+    for (int i = 0; i < pieceCount; ++i)
+        index = (index << 6) | squares[i];
+    return index;
+}
+
+// Tables written by bitbase_generator, mapped in memory
+class Bitbases {
+    public:
+        bool load(const std::string& directory); // True if at least one table was found
+        bool isLoaded(int table) const { return files[table].isOpen(); }
+        bool hasDistances(int table) const { return distanceFiles[table].isOpen(); }
+
+        // True when the strong side wins with best play
+        bool probe(int table, uint32_t index) const {
+            const unsigned char* bits = files[table].bytes() + BITBASE_HEADER_SIZE;
+            return (bits[index >> 3] >> (index & 7)) & 1;
+        }
+
+        // Plies to mate of the strong side, -1 when it doesn't win
+        int distanceToMate(int table, uint32_t index) const {
+            return distanceFiles[table].bytes()[BITBASE_HEADER_SIZE + index] - 1;
+        }
+
+    private:
+        MappedFile files[BITBASE_COUNT];
+        MappedFile distanceFiles[BITBASE_COUNT];
+
+        bool openTable(MappedFile& file, const std::string& path, const char* magic, size_t dataSize, int table);
+};
+
+#endif
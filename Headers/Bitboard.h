@@ -0,0 +1,155 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+
+// Square 0 = a1, 7 = h1, 63 = h8 : east is +1, north is +8
+constexpr uint64_t FILE_A = 0x0101010101010101ULL;
+constexpr uint64_t FILE_B = 0x0202020202020202ULL;
+constexpr uint64_t FILE_G = 0x4040404040404040ULL;
+constexpr uint64_t FILE_H = 0x8080808080808080ULL;
+
+// One step, bits leaving the board are lost
+inline uint64_t northOne(uint64_t b) { return b << 8; }
+inline uint64_t southOne(uint64_t b) { return b >> 8; }
+inline uint64_t eastOne(uint64_t b) { return (b & ~FILE_H) << 1; }
+inline uint64_t westOne(uint64_t b) { return (b & ~FILE_A) >> 1; }
+inline uint64_t northEastOne(uint64_t b) { return (b & ~FILE_H) << 9; }
+inline uint64_t northWestOne(uint64_t b) { return (b & ~FILE_A) << 7; }
+inline uint64_t southEastOne(uint64_t b) { return (b & ~FILE_H) >> 7; }
+inline uint64_t southWestOne(uint64_t b) { return (b & ~FILE_A) >> 9; }
+
+// Kogge-Stone fills : copy every bit to the end of its file
+inline uint64_t northFill(uint64_t b) {
+    b |= b << 8;
+    b |= b << 16;
+    b |= b << 32;
+    return b;
+}
+
+inline uint64_t southFill(uint64_t b) {
+    b |= b >> 8;
+    b |= b >> 16;
+    b |= b >> 32;
+    return b;
+}
+
+inline uint64_t fileFill(uint64_t b) {
+    return northFill(b) | southFill(b);
+}
+
+inline uint64_t whitePawnAttacks(uint64_t pawns) {
+    return northEastOne(pawns) | northWestOne(pawns);
+}
+
+inline uint64_t blackPawnAttacks(uint64_t pawns) {
+    return southEastOne(pawns) | southWestOne(pawns);
+}
+
+inline uint64_t knightAttacks(uint64_t knights) {
+    uint64_t l1 = (knights >> 1) & ~FILE_H;
+    uint64_t l2 = (knights >> 2) & ~(FILE_G | FILE_H);
+    uint64_t r1 = (knights << 1) & ~FILE_A;
+    uint64_t r2 = (knights << 2) & ~(FILE_A | FILE_B);
+    uint64_t h1 = l1 | r1;
+    uint64_t h2 = l2 | r2;
+    return (h1 << 16) | (h1 >> 16) | (h2 << 8) | (h2 >> 8);
+}
+
+inline uint64_t kingAttacks(uint64_t kings) {
+    uint64_t attacks = eastOne(kings) | westOne(kings);
+    kings |= attacks;
+    return attacks | northOne(kings) | southOne(kings);
+}
+
+// Kogge-Stone occluded fills : the sliders are spread over the empty squares,
+// the attacks are the fill moved one more step (the first blocker is attacked)
+inline uint64_t northAttacks(uint64_t gen, uint64_t empty) {
+    gen |= empty & (gen << 8);
+    empty &= empty << 8;
+    gen |= empty & (gen << 16);
+    empty &= empty << 16;
+    gen |= empty & (gen << 32);
+    return northOne(gen);
+}
+
+inline uint64_t southAttacks(uint64_t gen, uint64_t empty) {
+    gen |= empty & (gen >> 8);
+    empty &= empty >> 8;
+    gen |= empty & (gen >> 16);
+    empty &= empty >> 16;
+    gen |= empty & (gen >> 32);
+    return southOne(gen);
+}
+
+inline uint64_t eastAttacks(uint64_t gen, uint64_t empty) {
+    empty &= ~FILE_A;
+    gen |= empty & (gen << 1);
+    empty &= empty << 1;
+    gen |= empty & (gen << 2);
+    empty &= empty << 2;
+    gen |= empty & (gen << 4);
+    return eastOne(gen);
+}
+
+inline uint64_t westAttacks(uint64_t gen, uint64_t empty) {
+    empty &= ~FILE_H;
+    gen |= empty & (gen >> 1);
+    empty &= empty >> 1;
+    gen |= empty & (gen >> 2);
+    empty &= empty >> 2;
+    gen |= empty & (gen >> 4);
+    return westOne(gen);
+}
+
+inline uint64_t northEastAttacks(uint64_t gen, uint64_t empty) {
+    empty &= ~FILE_A;
+    gen |= empty & (gen << 9);
+    empty &= empty << 9;
+    gen |= empty & (gen << 18);
+    empty &= empty << 18;
+    gen |= empty & (gen << 36);
+    return northEastOne(gen);
+}
+
+inline uint64_t northWestAttacks(uint64_t gen, uint64_t empty) {
+    empty &= ~FILE_H;
+    gen |= empty & (gen << 7);
+    empty &= empty << 7;
+    gen |= empty & (gen << 14);
+    empty &= empty << 14;
+    gen |= empty & (gen << 28);
+    return northWestOne(gen);
+}
+
+inline uint64_t southEastAttacks(uint64_t gen, uint64_t empty) {
+    empty &= ~FILE_A;
+    gen |= empty & (gen >> 7);
+    empty &= empty >> 7;
+    gen |= empty & (gen >> 14);
+    empty &= empty >> 14;
+    gen |= empty & (gen >> 28);
+    return southEastOne(gen);
+}
+
+inline uint64_t southWestAttacks(uint64_t gen, uint64_t empty) {
+    empty &= ~FILE_H;
+    gen |= empty & (gen >> 9);
+    empty &= empty >> 9;
+    gen |= empty & (gen >> 18);
+    empty &= empty >> 18;
+    gen |= empty & (gen >> 36);
+    return southWestOne(gen);
+}
+
+inline uint64_t rookAttacks(uint64_t rooks, uint64_t empty) {
+    return northAttacks(rooks, empty) | southAttacks(rooks, empty) |
+           eastAttacks(rooks, empty) | westAttacks(rooks, empty);
+}
+
+inline uint64_t bishopAttacks(uint64_t bishops, uint64_t empty) {
+    return northEastAttacks(bishops, empty) | northWestAttacks(bishops, empty) |
+           southEastAttacks(bishops, empty) | southWestAttacks(bishops, empty);
+}
+
+#endif
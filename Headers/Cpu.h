@@ -0,0 +1,79 @@
+#ifndef CPU_H
+#define CPU_H
+
+#include "Bitboard.h"
+#include <cstdint>
+
+// Instruction sets of the hot kernels (attack maps, attack evaluation, attacked square test, move generation). The binary
+// holds one version per level, built with the same code, and uses the best one the CPU has (CPUID at startup)
+enum CpuLevel {
+    CPU_GENERIC, // Any x86-64 (or another architecture) : popcount and bit scans in software, Kogge-Stone sliders
+    CPU_POPCNT,  // POPCNT instruction
+    CPU_BMI2     // POPCNT, BMI1 and BMI2 : sliders looked up in tables indexed with PEXT
+};
+
+extern CpuLevel cpuLevel; // Read by the kernels
+
+CpuLevel cpuSupportedLevel();     // cpuLevel starts there, but at CPU_POPCNT on AMD CPUs with a slow PEXT
+void setCpuLevel(CpuLevel level); // To compare the versions : never above cpuSupportedLevel()
+const char* cpuLevelName(CpuLevel level);
+
+#if defined(__x86_64__)
+#define CPU_X86_64 1
+#include <immintrin.h>
+
+// Attacks of a slider by square : PEXT packs the occupancy of its rays (edges left out, nothing
+// behind them) into the index of the attack set. Only filled when the CPU has BMI2.
+struct PextTable {
+    uint64_t mask[64];
+    uint32_t offset[64];
+};
+
+constexpr int PEXT_ATTACKS_SIZE = 102400 + 5248; // Rooks, then bishops
+
+extern PextTable ROOK_PEXT;
+extern PextTable BISHOP_PEXT;
+extern uint64_t PEXT_ATTACKS[PEXT_ATTACKS_SIZE];
+
+__attribute__((target("bmi2")))
+inline uint64_t rookAttacksPext(int square, uint64_t occupied) {
+    return PEXT_ATTACKS[ROOK_PEXT.offset[square] + _pext_u64(occupied, ROOK_PEXT.mask[square])];
+}
+
+__attribute__((target("bmi2")))
+inline uint64_t bishopAttacksPext(int square, uint64_t occupied) {
+    return PEXT_ATTACKS[BISHOP_PEXT.offset[square] + _pext_u64(occupied, BISHOP_PEXT.mask[square])];
+}
+#endif
+
+// The kernels are inlined into the wrapper of their level, whose target attribute picks the instructions
+#define KERNEL inline __attribute__((always_inline))
+
+// Attacks of all the sliders of a bitboard : in one pass of the fills, or one lookup per piece
+template <CpuLevel level>
+KERNEL uint64_t bishopAttacksOf(uint64_t bishops, uint64_t occupied) {
+#ifdef CPU_X86_64
+    if constexpr (level == CPU_BMI2) {
+        uint64_t attacks = 0;
+        for (; bishops; bishops &= bishops - 1)
+            attacks |= bishopAttacksPext(__builtin_ctzll(bishops), occupied);
+        return attacks;
+    }
+#endif
+    return bishopAttacks(bishops, ~occupied);
+}
+
+template <CpuLevel level>
+KERNEL uint64_t rookAttacksOf(uint64_t rooks, uint64_t occupied) {
+#ifdef CPU_X86_64
+    if constexpr (level == CPU_BMI2) {
+        uint64_t attacks = 0;
+        for (; rooks; rooks &= rooks - 1)
+            attacks |= rookAttacksPext(__builtin_ctzll(rooks), occupied);
+        return attacks;
+    }
+#endif
+    return rookAttacks(rooks, ~occupied);
+}
+
+#endif
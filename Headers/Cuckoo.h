@@ -0,0 +1,78 @@
+#ifndef CUCKOO_H
+#define CUCKOO_H
+
+#include "ZobristHashing.h"
+#include <array>
+#include <cstdint>
+
+// Upcoming repetitions (Marcel van Kervinck's method) : every reversible move of a piece between two squares,
+// stored by the XOR of its Zobrist keys and the side key. If the hash of the position XOR the hash of a position
+// an odd number of plies ago is one of these keys, a single move takes the board back there.
+// Pawns never move back and are left out : 2 x 1834 moves of knights, bishops, rooks, queens and kings.
+constexpr int CUCKOO_SIZE = 8192;
+constexpr int CUCKOO_MOVES = 3668;
+
+constexpr int cuckooSlot1(uint64_t key) { return static_cast<int>(key & (CUCKOO_SIZE - 1)); }
+constexpr int cuckooSlot2(uint64_t key) { return static_cast<int>((key >> 16) & (CUCKOO_SIZE - 1)); }
+
+// Piece (PieceType % 6) going from a to b on an empty board
+constexpr bool reachesOnEmptyBoard(int type, int a, int b) {
+    int fileDistance = (a & 7) > (b & 7) ? (a & 7) - (b & 7) : (b & 7) - (a & 7);
+    int rankDistance = (a >> 3) > (b >> 3) ? (a >> 3) - (b >> 3) : (b >> 3) - (a >> 3);
+    bool diagonal = fileDistance == rankDistance;
+    bool straight = fileDistance == 0 || rankDistance == 0;
+    switch (type) {
+        case 1: return fileDistance * rankDistance == 2;
+        case 2: return diagonal;
+        case 3: return straight;
+        case 4: return diagonal || straight;
+        case 5: return fileDistance <= 1 && rankDistance <= 1;
+    }
+    return false;
+}
+
+// Moves packed on 16 bits : from | to << 6 | PieceType << 12 (never 0, pawns are not in the table)
+class CuckooTable {
+    public:
+        std::array<uint64_t, CUCKOO_SIZE> keys{};
+        std::array<uint16_t, CUCKOO_SIZE> moves{};
+        int count = 0;
+
+        constexpr CuckooTable() {
+            for (int piece = 0; piece < NUM_PIECES; ++piece) {
+                if (piece % 6 == 0)
+                    continue;
+                for (int a = 0; a < NUM_SQUARES; ++a) {
+                    for (int b = a + 1; b < NUM_SQUARES; ++b) {
+                        if (!reachesOnEmptyBoard(piece % 6, a, b))
+                            continue;
+                        insert(ZOBRIST.pieceSquare[piece][a] ^ ZOBRIST.pieceSquare[piece][b] ^ ZOBRIST.sideToMove,
+                               static_cast<uint16_t>(a | (b << 6) | (piece << 12)));
+                        count++;
+                    }
+                }
+            }
+        }
+
+    private:
+        // Each key has 2 slots : the one in the way is pushed to its other slot
+        constexpr void insert(uint64_t key, uint16_t move) {
+            int slot = cuckooSlot1(key);
+            while (true) {
+                uint64_t oldKey = keys[slot];
+                uint16_t oldMove = moves[slot];
+                keys[slot] = key;
+                moves[slot] = move;
+                if (oldMove == 0)
+                    return;
+                key = oldKey;
+                move = oldMove;
+                slot = slot == cuckooSlot1(key) ? cuckooSlot2(key) : cuckooSlot1(key);
+            }
+        }
+};
+
+inline constexpr CuckooTable CUCKOO;
+static_assert(CUCKOO.count == CUCKOO_MOVES, "Reversible moves of the cuckoo table");
+
+#endif
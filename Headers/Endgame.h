@@ -0,0 +1,48 @@
+#ifndef ENDGAME_H
+#define ENDGAME_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+
+// Specialised evaluations of known endgames, chosen once by material (Material.h).
+// strongSide : 0 White, 1 Black. The evaluations return White - Black, the scales 0 .. SCALE_NORMAL.
+typedef int (*EndgameEvaluation)(const uint64_t* bitboards, int strongSide);
+typedef int (*EndgameScale)(const uint64_t* bitboards, int strongSide);
+
+constexpr int SCALE_NORMAL = 64;
+constexpr int SCALE_DRAW = 0;
+constexpr int SCALE_ONE_PAWN = 48; // Ahead by less than a bishop with a single pawn left
+
+// Bonuses that make the search drive the weak king away
+constexpr int PUSH_TO_EDGE = 20;   // By line from the center
+constexpr int PUSH_TO_CORNER = 20; // By step closer to a mating corner
+constexpr int PUSH_CLOSE = 10;     // By step between the kings
+
+inline int squareDistance(int a, int b) {
+    return std::max(std::abs((a & 7) - (b & 7)), std::abs((a >> 3) - (b >> 3)));
+}
+
+inline int edgeDistance(int square) {
+    int file = square & 7, rank = square >> 3;
+    return std::min(std::min(file, 7 - file), std::min(rank, 7 - rank));
+}
+
+inline bool isDarkSquare(int square) {
+    return (((square >> 3) + (square & 7)) & 1) == 0; // a1 is dark
+}
+
+// KBNK : only the corners of the color of the bishop can be mated
+inline int bishopCornerDistance(int square, bool darkBishop) {
+    return darkBishop ? std::min(squareDistance(square, 0), squareDistance(square, 63))
+                      : std::min(squareDistance(square, 7), squareDistance(square, 56));
+}
+
+int evaluateDraw(const uint64_t* bitboards, int strongSide);
+int evaluateKXK(const uint64_t* bitboards, int strongSide);  // Lone king against mating material
+int evaluateKBNK(const uint64_t* bitboards, int strongSide);
+int evaluateKRKP(const uint64_t* bitboards, int strongSide); // Rook against a pawn
+
+int scaleOppositeBishops(const uint64_t* bitboards, int strongSide);
+
+#endif
@@ -0,0 +1,34 @@
+#ifndef EVALTRACE_H
+#define EVALTRACE_H
+
+// Flat index of every term of the classical evaluation, used by the tuner.
+// A parameter has a middlegame and an endgame weight, its coefficient is White - Black.
+enum EvalParam {
+    PARAM_MATERIAL = 0,                              // 6, by PieceType % 6 (king unused)
+    PARAM_PST = PARAM_MATERIAL + 6,                  // 6 * 64, same layout as MG_TABLE / EG_TABLE
+    PARAM_DOUBLED_PAWN = PARAM_PST + 6 * 64,
+    PARAM_ISOLATED_PAWN,
+    PARAM_BACKWARD_PAWN,
+    PARAM_PASSED_PAWN,                               // 8, by relative rank
+    PARAM_MOBILITY = PARAM_PASSED_PAWN + 8,          // 6, by PieceType % 6
+    PARAM_KING_ZONE_ATTACK = PARAM_MOBILITY + 6,     // 6, middlegame only
+    PARAM_HANGING_PIECE = PARAM_KING_ZONE_ATTACK + 6,
+    PARAM_PAWN_THREAT,
+    PARAM_BISHOP_PAIR,
+    PARAM_KNIGHT_PAWNS,                              // Knights * (own pawns - 5)
+    PARAM_ROOK_PAWNS,                                // Rooks * (own pawns - 5)
+    PARAM_COUNT
+};
+
+// Filled by the evaluation functions when they get a trace (never during the search)
+struct EvalTrace {
+    int coefficients[PARAM_COUNT] = {};
+    int scale = 64;           // The endgame part is multiplied by scale / 64 (Material.h)
+    bool specialised = false; // Known endgame : the score doesn't come from the terms
+
+    void add(int param, int count) {
+        coefficients[param] += count;
+    }
+};
+
+#endif
@@ -0,0 +1,234 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <cstdint>
+
+// Centipawns, indexed by PAWN, KNIGHT, BISHOP, ROOK, QUEEN, KING (PieceType % 6)
+constexpr int MG_VALUE[6] = {82, 337, 365, 477, 1025, 0};
+constexpr int EG_VALUE[6] = {94, 281, 297, 512, 936, 0};
+
+// Indexed by PieceType, white pieces count positive and black pieces negative
+constexpr int MATERIAL_VALUE[12] = {82, 337, 365, 477, 1025, 0, -82, -337, -365, -477, -1025, 0};
+
+// Game phase : 24 with all the pieces on the board, 0 with only kings and pawns
+constexpr int PHASE_MAX = 24;
+constexpr int PHASE_VALUE[12] = {0, 1, 1, 2, 4, 0, 0, 1, 1, 2, 4, 0};
+
+// Material key : the number of pieces of each PieceType packed on 4 bits (kings are not counted),
+// so the key is updated by an addition and the counts are read back from it.
+constexpr uint64_t MATERIAL_KEY_UNIT[12] = {
+    1ULL << 0, 1ULL << 4, 1ULL << 8, 1ULL << 12, 1ULL << 16, 0,
+    1ULL << 20, 1ULL << 24, 1ULL << 28, 1ULL << 32, 1ULL << 36, 0
+};
+
+// Knights, bishops, rooks and queens of a side, [0] White, [1] Black
+constexpr uint64_t NON_PAWN_KEY_MASK[2] = {
+    15 * (MATERIAL_KEY_UNIT[1] | MATERIAL_KEY_UNIT[2] | MATERIAL_KEY_UNIT[3] | MATERIAL_KEY_UNIT[4]),
+    15 * (MATERIAL_KEY_UNIT[7] | MATERIAL_KEY_UNIT[8] | MATERIAL_KEY_UNIT[9] | MATERIAL_KEY_UNIT[10])
+};
+
+inline int materialCount(uint64_t materialKey, int piece) { // Not for the kings
+    return static_cast<int>((materialKey >> (4 * (piece < 6 ? piece : piece - 1))) & 15);
+}
+
+// Tables seen from White, as on the board : first line = rank 8, last line = rank 1.
+constexpr int MG_TABLE[6][64] = {
+    { // Pawn
+         0,   0,   0,   0,   0,   0,   0,   0,
+        50,  50,  50,  50,  50,  50,  50,  50,
+        10,  10,  20,  30,  30,  20,  10,  10,
+         5,   5,  10,  25,  25,  10,   5,   5,
+         0,   0,   0,  20,  20,   0,   0,   0,
+         5,  -5, -10,   0,   0, -10,  -5,   5,
+         5,  10,  10, -20, -20,  10,  10,   5,
+         0,   0,   0,   0,   0,   0,   0,   0
+    },
+    { // Knight
+       -50, -40, -30, -30, -30, -30, -40, -50,
+       -40, -20,   0,   0,   0,   0, -20, -40,
+       -30,   0,  10,  15,  15,  10,   0, -30,
+       -30,   5,  15,  20,  20,  15,   5, -30,
+       -30,   0,  15,  20,  20,  15,   0, -30,
+       -30,   5,  10,  15,  15,  10,   5, -30,
+       -40, -20,   0,   5,   5,   0, -20, -40,
+       -50, -40, -30, -30, -30, -30, -40, -50
+    },
+    { // Bishop
+       -20, -10, -10, -10, -10, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,  10,  10,   5,   0, -10,
+       -10,   5,   5,  10,  10,   5,   5, -10,
+       -10,   0,  10,  10,  10,  10,   0, -10,
+       -10,  10,  10,  10,  10,  10,  10, -10,
+       -10,   5,   0,   0,   0,   0,   5, -10,
+       -20, -10, -10, -10, -10, -10, -10, -20
+    },
+    { // Rook
+         0,   0,   0,   0,   0,   0,   0,   0,
+         5,  10,  10,  10,  10,  10,  10,   5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+         0,   0,   0,   5,   5,   0,   0,   0
+    },
+    { // Queen
+       -20, -10, -10,  -5,  -5, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,   5,   5,   5,   0, -10,
+        -5,   0,   5,   5,   5,   5,   0,  -5,
+         0,   0,   5,   5,   5,   5,   0,  -5,
+       -10,   5,   5,   5,   5,   5,   0, -10,
+       -10,   0,   5,   0,   0,   0,   0, -10,
+       -20, -10, -10,  -5,  -5, -10, -10, -20
+    },
+    { // King : stay behind the pawns
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -30, -40, -40, -50, -50, -40, -40, -30,
+       -20, -30, -30, -40, -40, -30, -30, -20,
+       -10, -20, -20, -20, -20, -20, -20, -10,
+        20,  20,   0,   0,   0,   0,  20,  20,
+        20,  30,  10,   0,   0,  10,  30,  20
+    }
+};
+
+constexpr int EG_TABLE[6][64] = {
+    { // Pawn : the closer to promotion the better
+         0,   0,   0,   0,   0,   0,   0,   0,
+        80,  80,  80,  80,  80,  80,  80,  80,
+        50,  50,  50,  50,  50,  50,  50,  50,
+        30,  30,  30,  30,  30,  30,  30,  30,
+        15,  15,  15,  15,  15,  15,  15,  15,
+         5,   5,   5,   5,   5,   5,   5,   5,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0
+    },
+    { // Knight
+       -50, -40, -30, -30, -30, -30, -40, -50,
+       -40, -20,   0,   0,   0,   0, -20, -40,
+       -30,   0,  10,  15,  15,  10,   0, -30,
+       -30,   5,  15,  20,  20,  15,   5, -30,
+       -30,   0,  15,  20,  20,  15,   0, -30,
+       -30,   5,  10,  15,  15,  10,   5, -30,
+       -40, -20,   0,   5,   5,   0, -20, -40,
+       -50, -40, -30, -30, -30, -30, -40, -50
+    },
+    { // Bishop
+       -20, -10, -10, -10, -10, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,  10,  10,   5,   0, -10,
+       -10,   5,   5,  10,  10,   5,   5, -10,
+       -10,   0,  10,  10,  10,  10,   0, -10,
+       -10,  10,  10,  10,  10,  10,  10, -10,
+       -10,   5,   0,   0,   0,   0,   5, -10,
+       -20, -10, -10, -10, -10, -10, -10, -20
+    },
+    { // Rook
+         0,   0,   0,   0,   0,   0,   0,   0,
+         5,   5,   5,   5,   5,   5,   5,   5,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0,
+         0,   0,   0,   0,   0,   0,   0,   0
+    },
+    { // Queen
+       -20, -10, -10,  -5,  -5, -10, -10, -20,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -10,   0,   5,   5,   5,   5,   0, -10,
+        -5,   0,   5,   5,   5,   5,   0,  -5,
+        -5,   0,   5,   5,   5,   5,   0,  -5,
+       -10,   0,   5,   5,   5,   5,   0, -10,
+       -10,   0,   0,   0,   0,   0,   0, -10,
+       -20, -10, -10,  -5,  -5, -10, -10, -20
+    },
+    { // King : go to the center
+       -50, -40, -30, -20, -20, -30, -40, -50,
+       -30, -20, -10,   0,   0, -10, -20, -30,
+       -30, -10,  20,  30,  30,  20, -10, -30,
+       -30, -10,  30,  40,  40,  30, -10, -30,
+       -30, -10,  30,  40,  40,  30, -10, -30,
+       -30, -10,  20,  30,  30,  20, -10, -30,
+       -30, -30,   0,   0,   0,   0, -30, -30,
+       -50, -30, -30, -30, -30, -30, -30, -50
+    }
+};
+
+struct PieceSquareTables {
+    int mg[12][64]; // Middlegame
+    int eg[12][64]; // Endgame
+};
+
+// Value of the piece + table, for all the 12 PieceType.
+// Square 0 (a1) is the last line of a table for White, Black reads the table upside down.
+constexpr PieceSquareTables makePieceSquareTables() {
+    PieceSquareTables tables = {};
+
+    for (int type = 0; type < 6; ++type) {
+        for (int square = 0; square < 64; ++square) {
+            tables.mg[type][square] = MG_VALUE[type] + MG_TABLE[type][square ^ 56];
+            tables.eg[type][square] = EG_VALUE[type] + EG_TABLE[type][square ^ 56];
+
+            tables.mg[type + 6][square] = -(MG_VALUE[type] + MG_TABLE[type][square]);
+            tables.eg[type + 6][square] = -(EG_VALUE[type] + EG_TABLE[type][square]);
+        }
+    }
+
+    return tables;
+}
+
+constexpr PieceSquareTables PST = makePieceSquareTables();
+
+static_assert(PST.mg[0][12] == -PST.mg[6][52], "Black tables must mirror White tables");
+static_assert(PST.eg[5][4] == -PST.eg[11][60], "Black tables must mirror White tables");
+
+// Evaluation updated by makeMove / unMakeMove each time a piece is added or removed
+struct EvalState {
+    int material = 0; // Already inside mg and eg, kept for the search
+    int mg = 0;
+    int eg = 0;
+    int phase = 0;
+    uint64_t materialKey = 0;
+
+    void add(int piece, int square) {
+        material += MATERIAL_VALUE[piece];
+        materialKey += MATERIAL_KEY_UNIT[piece];
+        mg += PST.mg[piece][square];
+        eg += PST.eg[piece][square];
+        phase += PHASE_VALUE[piece];
+    }
+
+    void remove(int piece, int square) {
+        material -= MATERIAL_VALUE[piece];
+        materialKey -= MATERIAL_KEY_UNIT[piece];
+        mg -= PST.mg[piece][square];
+        eg -= PST.eg[piece][square];
+        phase -= PHASE_VALUE[piece];
+    }
+
+    void move(int piece, int from, int to) {
+        mg += PST.mg[piece][to] - PST.mg[piece][from];
+        eg += PST.eg[piece][to] - PST.eg[piece][from];
+    }
+
+    // Interpolation between middlegame and endgame (promotions can go above PHASE_MAX)
+    int taper(int mgScore, int egScore) const {
+        int p = phase > PHASE_MAX ? PHASE_MAX : phase;
+        return (mgScore * p + egScore * (PHASE_MAX - p)) / PHASE_MAX;
+    }
+
+    int score() const {
+        return taper(mg, eg);
+    }
+
+    bool operator==(const EvalState& other) const {
+        return material == other.material && mg == other.mg && eg == other.eg && phase == other.phase &&
+               materialKey == other.materialKey;
+    }
+};
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only file mapped in memory : pages are only read from the disk when they are used
+class MappedFile {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::string& path);
+        void close();
+        bool isOpen() const { return data != nullptr; }
+
+        const unsigned char* bytes() const { return data; }
+        size_t size() const { return mappedSize; }
+
+    private:
+        const unsigned char* data = nullptr;
+        size_t mappedSize = 0;
+#ifdef _WIN32
+        void* mapping = nullptr;
+#endif
+};
+
+#endif
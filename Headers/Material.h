@@ -0,0 +1,59 @@
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include "Evaluation.h"
+#include "Endgame.h"
+#include <cstdint>
+#include <vector>
+
+constexpr int MATERIAL_HASH_SIZE = 1 << 13; // Entries, must be a power of 2
+
+// Imbalance in centipawns (middlegame, endgame)
+constexpr int BISHOP_PAIR_MG = 30;
+constexpr int BISHOP_PAIR_EG = 50;
+constexpr int KNIGHT_PAWNS_MG = 4; // By knight and by own pawn above 5 : knights like closed positions
+constexpr int KNIGHT_PAWNS_EG = 4;
+constexpr int ROOK_PAWNS_MG = -6;  // Rooks like open ones
+constexpr int ROOK_PAWNS_EG = -6;
+
+// Everything that only depends on the material key (EvalState::materialKey)
+struct MaterialEntry {
+    uint64_t key = ~0ULL; // No material key has all its bits set
+    int imbalanceMg = 0;  // White - Black
+    int imbalanceEg = 0;
+    int phase = 0;        // Capped to PHASE_MAX
+    int strongSide = 0;
+    EndgameEvaluation evaluation = nullptr; // Known endgame : replaces the whole evaluation
+    EndgameScale scale[2] = {nullptr, nullptr};
+    int factor[2] = {SCALE_NORMAL, SCALE_NORMAL}; // Used when there is no scale function
+
+    // Scale of the side ahead in the endgame
+    int scaleFactor(const uint64_t* bitboards, int eg) const {
+        int side = eg > 0 ? 0 : 1;
+        return scale[side] ? scale[side](bitboards, side) : factor[side];
+    }
+
+    int taper(int mgScore, int egScore) const {
+        return (mgScore * phase + egScore * (PHASE_MAX - phase)) / PHASE_MAX;
+    }
+};
+
+struct EvalTrace;
+
+MaterialEntry computeMaterial(uint64_t key, EvalTrace* trace = nullptr);
+
+// Direct mapped : a few hundred material keys are seen in a game, nearly every probe is a hit
+class MaterialTable {
+    public:
+        MaterialTable();
+        const MaterialEntry& probe(uint64_t key);
+        void clear();
+
+        int probes = 0;
+        int hits = 0;
+
+    private:
+        std::vector<MaterialEntry> entries;
+};
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef NNUE_H
+#define NNUE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// HalfKP network : for each side, (own king square, piece, square) with the 10 non-king pieces.
+// 2 x 256 accumulator -> 32 -> 32 -> 1
+constexpr uint32_t NNUE_VERSION = 1;
+constexpr int NNUE_PIECE_SQUARES = 10 * 64;
+constexpr int NNUE_INPUTS = 64 * NNUE_PIECE_SQUARES;
+constexpr int NNUE_L1 = 256;
+constexpr int NNUE_L2 = 32;
+constexpr int NNUE_L3 = 32;
+constexpr int NNUE_WEIGHT_SHIFT = 6; // Dense layers outputs are divided by 64
+constexpr int NNUE_OUTPUT_SCALE = 16; // Network output / 16 = centipawns
+
+// A piece that moved during the last move : from = -1 when added, to = -1 when removed
+struct DirtyPiece {
+    int piece;
+    int from;
+    int to;
+};
+
+// One per ply : filled lazily from the parent the first time the position is evaluated
+struct Accumulator {
+    alignas(32) int16_t values[2][NNUE_L1]; // [0] White point of view, [1] Black point of view
+    bool computed[2] = {false, false};
+    DirtyPiece dirty[3];
+    int dirtyCount = 0;
+};
+
+class NNUE {
+    public:
+        NNUE();
+        bool load(const std::string& path);
+        bool isLoaded() const { return loaded; }
+
+        void refresh(Accumulator& accumulator, const uint64_t* bitboards, int perspective) const;
+        void update(const Accumulator& parent, Accumulator& accumulator, const uint64_t* bitboards, int perspective) const;
+        int evaluate(const Accumulator& accumulator) const; // Centipawns, white is positive
+
+    private:
+        bool loaded = false;
+        bool useAvx2 = false;
+
+        std::vector<int16_t> featureBiases;  // [NNUE_L1]
+        std::vector<int16_t> featureWeights; // [NNUE_INPUTS][NNUE_L1]
+        std::vector<int32_t> l1Biases;       // [NNUE_L2]
+        std::vector<int8_t> l1Weights;       // [NNUE_L2][2 * NNUE_L1]
+        std::vector<int32_t> l2Biases;       // [NNUE_L3]
+        std::vector<int8_t> l2Weights;       // [NNUE_L3][NNUE_L2]
+        int32_t outputBias = 0;
+        std::vector<int8_t> outputWeights;   // [NNUE_L3]
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef OPENINGBOOK_H
+#define OPENINGBOOK_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+// Polyglot keys : 768 piece-square, 4 castling, 8 en passant files, 1 side to move
+constexpr int POLYGLOT_RANDOM_COUNT = 781;
+constexpr int POLYGLOT_CASTLING = 768;
+constexpr int POLYGLOT_EN_PASSANT = 772;
+constexpr int POLYGLOT_TURN = 780;
+
+// The Random64 numbers of Polyglot, written in hexadecimal ("0x...") in their order, are read from this file
+// next to the book. The documented key of the starting position tells whether they are the right ones.
+constexpr const char* POLYGLOT_RANDOM_FILE = "polyglot_random64.txt";
+constexpr uint64_t POLYGLOT_START_KEY = 0x463B96181691FC9CULL;
+
+// Polyglot .bin : entries of 16 bytes (key, move, weight, learn), big-endian, sorted by key.
+// The file is mapped in memory and never parsed.
+class OpeningBook {
+    public:
+        bool open(const std::string& bookPath);
+        void close();
+        bool isOpen() const { return file.isOpen(); }
+
+        uint64_t random(int index) const { return randoms[index]; }
+
+        // One of the moves of the position, chosen at random with the weights of the book
+        bool probe(uint64_t key, uint16_t& move);
+
+    private:
+        std::vector<uint64_t> randoms;
+        MappedFile file;
+        size_t entryCount = 0;
+        std::mt19937 rng{std::random_device{}()};
+
+        uint64_t keyAt(size_t index) const;
+        uint16_t read16(size_t offset) const;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef PAWNSTRUCTURE_H
+#define PAWNSTRUCTURE_H
+
+#include <cstdint>
+#include <vector>
+
+constexpr int PAWN_HASH_SIZE = 1 << 14; // Entries, must be a power of 2
+
+// Penalties and bonuses in centipawns (middlegame, endgame)
+constexpr int DOUBLED_PAWN_MG = -10;
+constexpr int DOUBLED_PAWN_EG = -20;
+constexpr int ISOLATED_PAWN_MG = -10;
+constexpr int ISOLATED_PAWN_EG = -15;
+constexpr int BACKWARD_PAWN_MG = -8;
+constexpr int BACKWARD_PAWN_EG = -10;
+constexpr int PASSED_PAWN_MG[8] = {0, 5, 10, 15, 25, 40, 60, 0}; // By relative rank
+constexpr int PASSED_PAWN_EG[8] = {0, 10, 20, 30, 50, 80, 120, 0};
+
+// Everything that only depends on the pawns, [0] for White and [1] for Black
+struct PawnEntry {
+    uint64_t key = 0;
+    int mg = 0; // White - Black
+    int eg = 0;
+    uint64_t passed[2] = {0, 0};
+    uint64_t attacks[2] = {0, 0};     // Squares attacked by the pawns now
+    uint64_t attackSpans[2] = {0, 0}; // Squares the pawns can attack by moving forward
+};
+
+struct EvalTrace;
+
+PawnEntry evaluatePawnStructure(uint64_t whitePawns, uint64_t blackPawns, EvalTrace* trace = nullptr);
+
+// Direct mapped, an entry is replaced by the last pawn structure with the same index
+class PawnHashTable {
+    public:
+        PawnHashTable();
+        const PawnEntry& probe(uint64_t key, uint64_t whitePawns, uint64_t blackPawns);
+        void clear();
+
+        int probes = 0;
+        int hits = 0;
+
+    private:
+        std::vector<PawnEntry> entries;
+};
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+
+// Time of the hot functions of the search, read from the time stamp counter. Only built with -DPROFILE_ZONES :
+// otherwise PROFILE_ZONE is empty and the search runs as before.
+enum ProfileZone {
+    ZONE_SEARCH,          // alphaBeta<ROOT> : its self time is the search itself (TT, pruning, loops)
+    ZONE_MOVE_GENERATION, // allMovesForWhite / Black, evasionMoves
+    ZONE_IS_IN_CHECK,
+    ZONE_MAKE_MOVE,       // makeMove, doMove
+    ZONE_UNMAKE_MOVE,     // unMakeMove, undoMove
+    ZONE_UPDATE_HASH,     // updateHash, updatePawnHash
+    ZONE_EVALUATION,      // evaluatePawnPower, classical or NNUE
+    ZONE_MOVE_ORDERING,
+    ZONE_COUNT
+};
+
+struct ZoneCounters {
+    uint64_t calls = 0;      // A zone entered inside itself (doMove -> makeMove) is only counted once
+    uint64_t cycles = 0;
+    uint64_t selfCycles = 0; // Without the zones called inside
+};
+
+class ProfileScope;
+
+// One per thread (the tuner searches on all the cores), reset by whoever reports it
+struct ProfileCounters {
+    ZoneCounters zones[ZONE_COUNT];
+    int active[ZONE_COUNT] = {};
+    ProfileScope* current = nullptr; // Innermost zone, its children time is given back to it
+};
+
+const char* profileZoneName(ProfileZone zone);
+std::string profileReport(const ProfileCounters& counters); // One line per zone, in % of ZONE_SEARCH
+
+#ifdef PROFILE_ZONES
+#if defined(__x86_64__)
+#include <x86intrin.h>
+inline uint64_t profileTicks() { return __rdtsc(); }
+#else
+#include <chrono>
+inline uint64_t profileTicks() { return std::chrono::steady_clock::now().time_since_epoch().count(); }
+#endif
+
+extern thread_local ProfileCounters profileCounters;
+
+class ProfileScope {
+    public:
+        explicit ProfileScope(ProfileZone zone) : zone(zone), parent(profileCounters.current), start(profileTicks()) {
+            profileCounters.current = this;
+            profileCounters.active[zone]++;
+        }
+
+        ~ProfileScope() {
+            uint64_t elapsed = profileTicks() - start;
+            ZoneCounters& counters = profileCounters.zones[zone];
+            counters.selfCycles += elapsed - children;
+            if (--profileCounters.active[zone] == 0) {
+                counters.calls++;
+                counters.cycles += elapsed;
+            }
+            if (parent)
+                parent->children += elapsed;
+            profileCounters.current = parent;
+        }
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator=(const ProfileScope&) = delete;
+
+    private:
+        ProfileZone zone;
+        ProfileScope* parent;
+        uint64_t start;
+        uint64_t children = 0;
+};
+
+#define PROFILE_ZONE(zone) ProfileScope profileScope(zone)
+#else
+#define PROFILE_ZONE(zone)
+#endif
+
+#endif
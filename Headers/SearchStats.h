@@ -0,0 +1,61 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <cstdint>
+#include <string>
+
+// Counters of one iteration of the search (a call of alphaBeta<ROOT>), reset by AI_chess before it.
+// Printed as UCI info lines, and written as one JSON object per line for the tuning scripts.
+struct SearchStats {
+    int depth = 0;            // Plies searched from the root, the root move included
+    bool white = true;        // Side to move at the root
+    int score = 0;            // White's point of view, as the search (UCI : the side to move's)
+    std::string bestMove;     // UCI notation
+
+    int64_t nodes = 0;        // alphaBeta and quiescence
+    int64_t qnodes = 0;       // Quiescence only
+
+    // Transposition table : keyed by the whole hash, a store only replaces the same position (no collision)
+    int64_t ttProbes = 0;
+    int64_t ttHits = 0;       // Entry deep enough
+    int64_t ttCutoffs = 0;    // ... whose score is the score of the node
+    int64_t ttStores = 0;
+    int64_t ttOverwrites = 0; // Stores over an entry of the same position
+    int64_t ttSize = 0;       // Entries after the iteration
+
+    // Evaluation cache : lossy, a collision replaces another position with the same index
+    int64_t evalProbes = 0;
+    int64_t evalHits = 0;
+    int64_t evalCollisions = 0;
+    int64_t bitbaseProbes = 0;
+
+    // Move loops of alphaBeta
+    int64_t betaCutoffs = 0;
+    int64_t firstMoveCutoffs = 0;
+
+    // Pruning, by technique : nodes cut, except futility (moves skipped) and LMR (moves reduced, searched again)
+    int64_t drawCutoffs = 0;  // Repetitions, fifty moves and upcoming repetitions
+    int64_t bitbaseCutoffs = 0;
+    int64_t reverseFutility = 0;
+    int64_t razoring = 0;
+    int64_t futility = 0;
+    int64_t nullMove = 0;
+    int64_t probCut = 0;
+    int64_t multiCut = 0;
+    int64_t lmrReductions = 0;
+    int64_t lmrResearches = 0;
+
+    // Time split, in seconds
+    double searchSeconds = 0; // alphaBeta<ROOT>
+    double totalSeconds = 0;  // The whole move : root moves, book, bitbases, search and the end of game checks
+
+    int64_t nps() const;
+    double firstMoveCutoffRate() const;
+    double branchingFactor() const; // nodes ^ (1 / depth)
+    int mateIn() const;             // Moves to the mate, < 0 when the side to move is mated, 0 without a mate score
+
+    std::string toInfo() const;     // "info depth ... pv ..." then "info string ..." with the rest
+    std::string toJson() const;     // One line
+};
+
+#endif
@@ -1,7 +1,6 @@
 #ifndef ZOBRIST_H
 #define ZOBRIST_H
 
-#include <random>
 #include <array>
 #include <cstdint>
 
@@ -12,20 +11,87 @@ constexpr int NUM_SQUARES = 64;
 constexpr int NUM_CASTLING_RIGHTS = 16; // 2**4 = 16
 constexpr int NUM_EN_PASSANT = 8;
 
+constexpr uint64_t ZOBRIST_SEED = 0x123456789ABCDEF0ULL;
+
+// Castling rights on 4 bits, as in computeInitialHash and the state stack
+constexpr int WHITE_KING_SIDE_RIGHT = 1;
+constexpr int WHITE_QUEEN_SIDE_RIGHT = 2;
+constexpr int BLACK_KING_SIDE_RIGHT = 4;
+constexpr int BLACK_QUEEN_SIDE_RIGHT = 8;
+constexpr int ALL_CASTLING_RIGHTS = 15;
+
+// Rights kept by a move, by square : a right is gone as soon as something leaves or lands on the square
+// of its king or rook. makeMove does rights &= CASTLING_MASK[from] & CASTLING_MASK[to]
+constexpr std::array<uint8_t, NUM_SQUARES> castlingMaskTable() {
+    std::array<uint8_t, NUM_SQUARES> mask{};
+    for (int square = 0; square < NUM_SQUARES; ++square)
+        mask[square] = ALL_CASTLING_RIGHTS;
+    mask[4] &= ~(WHITE_KING_SIDE_RIGHT | WHITE_QUEEN_SIDE_RIGHT);
+    mask[7] &= ~WHITE_KING_SIDE_RIGHT;
+    mask[0] &= ~WHITE_QUEEN_SIDE_RIGHT;
+    mask[60] &= ~(BLACK_KING_SIDE_RIGHT | BLACK_QUEEN_SIDE_RIGHT);
+    mask[63] &= ~BLACK_KING_SIDE_RIGHT;
+    mask[56] &= ~BLACK_QUEEN_SIDE_RIGHT;
+    return mask;
+}
+
+inline constexpr std::array<uint8_t, NUM_SQUARES> CASTLING_MASK = castlingMaskTable();
+
+// SplitMix64 : small enough to run in the compiler
+constexpr uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// All the keys are built at compile time (ZOBRIST below), nothing is generated when a board is created.
+// The extra row NONE (= 12) of the piece tables is 0 : a move without capture XORs nothing.
 class ZobristHashing {
     public:
-        std::array<std::array<uint64_t, NUM_SQUARES>, NUM_PIECES> pieceSquare;
-        std::array<uint64_t, NUM_CASTLING_RIGHTS> castlingRights;
-        std::array<uint64_t, NUM_EN_PASSANT> enPassantNum;
-        uint64_t sideToMove;
-        ZobristHashing(uint64_t seed);
-        uint64_t updateHash(uint64_t& hash, Move& move);
+        std::array<std::array<uint64_t, NUM_SQUARES>, NUM_PIECES + 1> pieceSquare{};
+        std::array<std::array<uint64_t, NUM_SQUARES>, NUM_PIECES + 1> pawnSquare{}; // Only the pawn rows, for the pawn key
+        std::array<uint64_t, NUM_CASTLING_RIGHTS> castlingRights{}; // Linear : castlingRights[a ^ b] = castlingRights[a] ^ castlingRights[b]
+        std::array<uint64_t, NUM_SQUARES + 1> enPassant{};          // By en passant square + 1 (the key of its file), 0 for -1
+        std::array<uint64_t, NUM_SQUARES> castlingRook{};           // Rook of a castling, by destination of the king
+        uint64_t sideToMove = 0;
 
-        int givePositionForCastlingRights(Move& move);
-        int givePositionForCastlingRightsBefore(Move& move);
+        constexpr ZobristHashing(uint64_t seed) {
+            uint64_t state = seed;
 
-};
+            for (int piece = 0; piece < NUM_PIECES; ++piece) {
+                for (int square = 0; square < NUM_SQUARES; ++square) {
+                    pieceSquare[piece][square] = splitMix64(state);
+                    if (piece == 0 || piece == 6)
+                        pawnSquare[piece][square] = pieceSquare[piece][square];
+                }
+            }
 
+            uint64_t rightKeys[4] = {splitMix64(state), splitMix64(state), splitMix64(state), splitMix64(state)};
+            for (int rights = 0; rights < NUM_CASTLING_RIGHTS; ++rights)
+                for (int i = 0; i < 4; ++i)
+                    if (rights & (1 << i))
+                        castlingRights[rights] ^= rightKeys[i];
+
+            uint64_t fileKeys[NUM_EN_PASSANT] = {};
+            for (int file = 0; file < NUM_EN_PASSANT; ++file)
+                fileKeys[file] = splitMix64(state);
+            for (int square = 0; square < NUM_SQUARES; ++square)
+                enPassant[square + 1] = fileKeys[square % 8];
+
+            sideToMove = splitMix64(state);
+
+            // White rook 7 -> 5 and 0 -> 3, black rook 63 -> 61 and 56 -> 59
+            castlingRook[6] = pieceSquare[3][7] ^ pieceSquare[3][5];
+            castlingRook[2] = pieceSquare[3][0] ^ pieceSquare[3][3];
+            castlingRook[62] = pieceSquare[9][63] ^ pieceSquare[9][61];
+            castlingRook[58] = pieceSquare[9][56] ^ pieceSquare[9][59];
+        }
+
+        uint64_t updateHash(uint64_t& hash, Move& move, int castlingBefore, int enPassantBefore, int enPassantAfter) const;
+        uint64_t updatePawnHash(uint64_t& pawnHash, Move& move) const;
+};
 
+inline constexpr ZobristHashing ZOBRIST(ZOBRIST_SEED);
 
 #endif
@@ -1,16 +1,90 @@
 #ifndef CHESSEBOARD_H
+#define CHESSEBOARD_H
 #include <SFML/Graphics.hpp>
 #include "ZobristHashing.h"
+#include "Evaluation.h"
+#include "PawnStructure.h"
+#include "Material.h"
+#include "Attacks.h"
+#include "EvalTrace.h"
+#include "NNUE.h"
+#include "OpeningBook.h"
+#include "Bitbase.h"
+#include "Cuckoo.h"
+#include "SearchStats.h"
 #include <unordered_map>
+#include <type_traits>
+
+constexpr int MAX_DEPTH = 64;
+constexpr int MAX_MOVES = 256;
+
+// State stack : allocated once, the oldest game moves are dropped before a search when it gets full
+constexpr int STATE_STACK_SIZE = 1024;
+constexpr int MAX_SEARCH_PLY = 256;
+
+// Scores are in centipawns, white is positive
+constexpr int INFINITE_SCORE = 32000;
+constexpr int MATE_SCORE = 30000;
+constexpr int BITBASE_WIN = 10000; // Known win of a bitbase, below the mate scores
+
+// Null move
+constexpr int NULL_MOVE_MIN_DEPTH = 3;
+constexpr int NULL_MOVE_REDUCTION = 2;
+
+// Late move reductions
+constexpr int LMR_MIN_DEPTH = 3;
+constexpr int LMR_MIN_MOVE_INDEX = 3;
+
+// Shallow depth pruning, margins indexed by the remaining depth
+constexpr int SHALLOW_PRUNING_MAX_DEPTH = 3;
+constexpr int REVERSE_FUTILITY_MARGIN[SHALLOW_PRUNING_MAX_DEPTH + 1] = {0, 150, 300, 450};
+constexpr int FUTILITY_MARGIN[SHALLOW_PRUNING_MAX_DEPTH + 1] = {0, 200, 350, 500};
+constexpr int RAZORING_MARGIN[SHALLOW_PRUNING_MAX_DEPTH + 1] = {0, 300, 500, 700};
+
+// ProbCut
+constexpr int PROBCUT_MIN_DEPTH = 4;
+constexpr int PROBCUT_REDUCTION = 3;
+constexpr int PROBCUT_MARGIN = 200;
+
+// Multi-cut
+constexpr int MULTI_CUT_MIN_DEPTH = 4;
+constexpr int MULTI_CUT_REDUCTION = 3;
+constexpr int MULTI_CUT_MOVES = 6;  // Moves tried
+constexpr int MULTI_CUT_CUTOFFS = 3; // Cutoffs needed to prune
+
+// Middlegame values of Evaluation.h
+constexpr int PIECE_VALUE[13] = {82, 337, 365, 477, 1025, 0, 82, 337, 365, 477, 1025, 0, 0};
+
+// Evaluation cache, direct mapped (number of entries, power of 2)
+constexpr int EVAL_CACHE_SIZE = 1 << 16;
+
+struct EvalCacheEntry {
+    uint32_t key = 0; // High half of the hash with its low bit set (0 : empty), the low half gives the index
+    int32_t score = 0;
+};
+
+// Node types of the search, known at compile time
+enum NodeType {
+    ROOT,
+    PV,
+    NON_PV
+};
+
+enum TTFlag {
+    EXACT,
+    LOWER_BOUND, // The real score is >= score
+    UPPER_BOUND  // The real score is <= score
+};
 
 struct TTEntry {
     int score;
     int depth;
+    TTFlag flag = EXACT;
 };
 
 enum MoveType {
     NORMAL_MOVE,
-    PROMOTION, // When a Pawn becomes a Queen
+    PROMOTION, // The pawn becomes move.promotion
     CASTLING,
     EN_PASSANT
 };
@@ -33,6 +107,10 @@ enum PieceType {
 
 enum CastlingType { KINGSIDE, QUEENSIDE };
 
+// Rook of a castling, by castlingIndex : white king side, white queen side, black king side, black queen side
+constexpr int CASTLING_ROOK_FROM[4] = {7, 0, 63, 56};
+constexpr int CASTLING_ROOK_TO[4] = {5, 3, 61, 59};
+
 struct Move {
     int from;
     int to;
@@ -40,19 +118,24 @@ struct Move {
     PieceType capturedType;  
     MoveType moveType = NORMAL_MOVE; 
     CastlingType castlingType = KINGSIDE;
+    PieceType promotion = NONE; // Knight to queen of the side, with moveType PROMOTION
+};
 
-    bool whiteKingSideCastlingBefore = true;
-    bool whiteQueenSideCastlingBefore = true;
-    bool blackKingSideCastlingBefore = true;
-    bool blackQueenSideCastlingBefore = true;
-
-    bool whiteKingSideCastlingAfter = true;
-    bool whiteQueenSideCastlingAfter = true;
-    bool blackKingSideCastlingAfter = true;
-    bool blackQueenSideCastlingAfter = true;
-
-    int enPassantSquareBefore = -1;
-    int enPassantSquareAfter = -1;
+inline int castlingIndex(const Move& move) {
+    return (move.piece >= BLACK_PAWN ? 2 : 0) + move.castlingType;
+}
+
+// What unMakeMove can't find in the move, one per move made : the game moves first, then the plies of
+// the search above them. Copied back as a whole, the hashes and the evaluation state aren't computed again.
+struct StateInfo {
+    uint64_t hash;
+    uint64_t pawnHash;
+    EvalState evalState;
+    int castling;       // 4 bits, as in ZobristHashing.h
+    int enPassant;
+    int rule50;         // Plies since the last capture or pawn move
+    int pliesFromNull;  // Repetitions don't go through a null move
+    PieceType captured;
 };
 
 struct Piece {
@@ -76,6 +159,41 @@ struct Piece {
     }
 };
 
+// Everything a move changes on the board, in one block : copy-make saves it before the move and
+// copies it back instead of undoing the move
+struct Position {
+    uint64_t bitboards[12];
+    uint64_t hash;
+    uint64_t pawnHash;
+    EvalState evalState;
+    int enPassant;
+    int accumulatorPly;
+    int rule50;
+    int pliesFromNull;
+    int castling; // 4 bits, as in ZobristHashing.h
+
+    bool operator==(const Position& other) const {
+        for (int i = 0; i < 12; ++i)
+            if (bitboards[i] != other.bitboards[i])
+                return false;
+        return castling == other.castling && hash == other.hash && pawnHash == other.pawnHash && evalState == other.evalState &&
+               enPassant == other.enPassant && accumulatorPly == other.accumulatorPly &&
+               rule50 == other.rule50 && pliesFromNull == other.pliesFromNull;
+    }
+};
+static_assert(std::is_trivially_copyable<Position>::value, "Position is copied with a plain assignment");
+static_assert(sizeof(Position) == 160, "Position size : update the README (copy-make)");
+
+// Everything makeMove changes : unMakeMove must give back the same snapshot, bit for bit
+struct BoardSnapshot {
+    Position position;
+    int statePly;
+
+    bool operator==(const BoardSnapshot& other) const {
+        return position == other.position && statePly == other.statePly;
+    }
+};
+
 class ChessBoard {
 
 private:
@@ -85,25 +203,56 @@ private:
     sf::Color DARK_COLOR;
     sf::RenderWindow& window;
     uint64_t currentHash;
+    uint64_t pawnHash; // Only the pawns, for the pawn hash table
+    PawnHashTable pawnHashTable;
+    MaterialTable materialTable;
+    std::vector<EvalCacheEntry> evalCache;
+    NNUE nnue;
+    std::vector<Accumulator> accumulators; // One per ply, only used with a network
+    int accumulatorPly = 0;
+    OpeningBook book;
+    Bitbases bitbases;
+    bool bitbaseRoot = false; // The game itself is in a bitbase without distances : wins are not cut
     std::unordered_map<uint64_t, TTEntry> transpositionTable;
-    std::vector<uint64_t> hashHistory;
-    ZobristHashing zobrist;
+    std::vector<StateInfo> states; // STATE_STACK_SIZE, never grows
+    int statePly = 0;
+    int rootPly = 0; // statePly of the root of the search : the game moves are below
+    Move rootBestMove; // Found by alphaBeta<ROOT>, from = -1 without legal move
+    int lmrReductions[MAX_DEPTH][MAX_MOVES];
+#ifdef VERIFY_STATE
+    std::vector<BoardSnapshot> debugSnapshots; // One per move made, compared by unMakeMove
+#endif
     
 
 
 public:
-    bool whiteKingSideCastling = true;
-    bool whiteQueenSideCastling = true;
-    bool blackKingSideCastling = true;
-    bool blackQueenSideCastling = true;
+    int castlingRights = ALL_CASTLING_RIGHTS; // 4 bits, as in ZobristHashing.h
 
     int enPassant = -1;
-    int counter_alpha_beta = 0;
-    int counter_same_hash = 0;
+    int rule50 = 0;
+    int pliesFromNull = 0;
+    SearchStats stats;             // Of the last search, see SearchStats.h
+    std::string statsPath;         // JSON lines of the searches are appended there, when set
+    bool copyMake = false; // The search takes its moves back by copying the saved Position
     
     Piece piece;
+    EvalState evalState;
     ChessBoard(int windowWidth, int windowHeight, int size, sf::RenderWindow& window);
-    uint64_t computeInitialHash();
+    uint64_t computeInitialHash(bool whiteToMove = true);
+    uint64_t computeInitialPawnHash();
+    uint64_t computePolyglotKey(bool whiteToMove);
+    EvalState computeEvalState();
+    bool loadFen(const std::string& fen, bool& whiteToMove);
+    void resetState(bool whiteToMove);
+    void trimStates();
+    BoardSnapshot snapshot() const;
+    Position savePosition() const;
+    void restorePosition(const Position& position);
+    void doMove(Move& move, Position& saved);
+    void undoMove(Move& move, const Position& saved);
+    uint64_t perft(int depth, bool isWhite);
+    bool verifyState(bool whiteToMove, std::string& error);
+    void checkState(bool whiteToMove, const char* where);
     void loadTextures();
     void draw();
     void drawChessPieces(uint64_t piece, sf::Sprite& sprite);
@@ -155,20 +304,42 @@ public:
     void movePiece(uint64_t* pieceFrom, uint64_t* pieceTo, int from, int to);
     void unMovePiece(uint64_t* pieceFrom, uint64_t* pieceTo, int from, int to);
     void undo(int positionFrom, int positionTo, uint64_t* piece, uint64_t* pieceCaptured);
-    int evaluate();
+    int evaluate(EvalTrace* trace = nullptr); // From scratch, the tuner reads the terms in the trace
     int evaluatePawnPower();
+    int evaluateCached();
+    void clearSearchTables();
+    bool loadNetwork(const std::string& path);
+    bool loadBook(const std::string& bookPath); // The Polyglot numbers next to it, see OpeningBook.h
+    bool probeBook(bool isWhite, std::vector<Move>& moves, Move& bookMove);
+    bool loadBitbases(const std::string& directory);
+    bool probeBitbase(bool isWhite, int depth, int& score, bool& exact);
+    void pushAccumulator(const Move* move);
+    int evaluateNNUE();
     std::vector<Move> allMovesForWhite();
     std::vector<Move> allMovesForBlack();
+    std::vector<Move> evasionMoves(bool isWhite);
     inline PieceType getPieceTypeIfThereIsABlackPieceAt(int position);
     inline PieceType getPieceTypeIfThereIsAWhitePieceAt(int position);
     Move getMoveForAPosition(int position, int to, PieceType pieceType, bool white);
-
-    int alphaBeta(int depth, bool isWhite, int alpha, int beta);
+    void addPawnMove(std::vector<Move>& movesList, int from, int to, bool white);
+
+    template <NodeType nodeType>
+    int alphaBeta(int depth, bool isWhite, int alpha, int beta, bool cutNode = false, bool nullMoveAllowed = true);
+    int quiescence(bool isWhite, int alpha, int beta, Piece* leaf = nullptr);
+    bool probCut(int depth, bool isWhite, int alpha, int beta, bool cutNode, int& score);
+    bool multiCut(int depth, bool isWhite, int alpha, int beta);
+    void initReductions();
+    void makeNullMove();
+    void unMakeNullMove();
+    bool isRepetition() const;
+    bool isFiftyMoveDraw(bool isWhite);
+    bool hasUpcomingRepetition(uint64_t occupied) const;
+    bool hasNonPawnMaterial(bool isWhite);
     void AI_chess(bool AIplaysBlack);
     bool isInCheck(bool isWhite);
     void moveOrdering(std::vector<Move>* moves);
-    bool makeMove(Move& move);
-    void unMakeMove(bool pawnBecomeQueen, Move& move);
+    void makeMove(Move& move);
+    void unMakeMove(Move& move);
     bool isAttacked(int position, bool isWhite);
     void possibilityCastle(std::vector<Move>& movesList, bool isWhite);
     void printMove(Move& move);
@@ -0,0 +1,66 @@
+#include "Headers/MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER size;
+    GetFileSizeEx(file, &size);
+    mappedSize = static_cast<size_t>(size.QuadPart);
+    mapping = mappedSize ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    CloseHandle(file);
+    if (mapping)
+        data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+    struct stat status;
+    fstat(file, &status);
+    mappedSize = static_cast<size_t>(status.st_size);
+    if (mappedSize) {
+        void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, file, 0);
+        if (address != MAP_FAILED)
+            data = static_cast<const unsigned char*>(address);
+    }
+    ::close(file); // The mapping stays valid
+#endif
+
+    if (!data) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data)
+        UnmapViewOfFile(data);
+    if (mapping)
+        CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    if (data)
+        munmap(const_cast<unsigned char*>(data), mappedSize);
+#endif
+    data = nullptr;
+    mappedSize = 0;
+}
@@ -0,0 +1,131 @@
+#include "Headers/Material.h"
+#include "Headers/EvalTrace.h"
+#include <algorithm>
+
+// Bishop pair, and the knights and rooks that get better or worse with the pawns of their side
+static void evaluateImbalance(uint64_t key, MaterialEntry& entry, EvalTrace* trace) {
+    for (int side = 0; side < 2; ++side) {
+        int us = side * 6;
+        int sign = side == 0 ? 1 : -1;
+        int extraPawns = materialCount(key, us) - 5;
+        int knightPawns = materialCount(key, us + 1) * extraPawns;
+        int rookPawns = materialCount(key, us + 3) * extraPawns;
+
+        if (materialCount(key, us + 2) >= 2) {
+            entry.imbalanceMg += sign * BISHOP_PAIR_MG;
+            entry.imbalanceEg += sign * BISHOP_PAIR_EG;
+            if (trace)
+                trace->add(PARAM_BISHOP_PAIR, sign);
+        }
+
+        entry.imbalanceMg += sign * (KNIGHT_PAWNS_MG * knightPawns + ROOK_PAWNS_MG * rookPawns);
+        entry.imbalanceEg += sign * (KNIGHT_PAWNS_EG * knightPawns + ROOK_PAWNS_EG * rookPawns);
+        if (trace) {
+            trace->add(PARAM_KNIGHT_PAWNS, sign * knightPawns);
+            trace->add(PARAM_ROOK_PAWNS, sign * rookPawns);
+        }
+    }
+}
+
+MaterialEntry computeMaterial(uint64_t key, EvalTrace* trace) {
+    MaterialEntry entry;
+    entry.key = key;
+
+    int count[12] = {};
+    int phase = 0;
+    for (int piece = 0; piece < 12; ++piece) {
+        if (piece == 5 || piece == 11)
+            continue;
+        count[piece] = materialCount(key, piece);
+        phase += PHASE_VALUE[piece] * count[piece];
+    }
+    entry.phase = std::min(phase, PHASE_MAX);
+
+    evaluateImbalance(key, entry, trace);
+
+    int pawns[2], minors[2], majors[2], nonPawn[2];
+    for (int side = 0; side < 2; ++side) {
+        const int* own = count + side * 6;
+        pawns[side] = own[0];
+        minors[side] = own[1] + own[2];
+        majors[side] = own[3] + own[4];
+        nonPawn[side] = own[1] * MG_VALUE[1] + own[2] * MG_VALUE[2] + own[3] * MG_VALUE[3] + own[4] * MG_VALUE[4];
+    }
+
+    // Nobody can mate : a minor piece or two knights at most on each side
+    bool insufficient = pawns[0] + pawns[1] + majors[0] + majors[1] == 0;
+    for (int side = 0; side < 2; ++side)
+        insufficient = insufficient && (minors[side] <= 1 || (count[side * 6 + 1] == 2 && count[side * 6 + 2] == 0));
+    if (insufficient) {
+        entry.evaluation = evaluateDraw;
+        return entry;
+    }
+
+    for (int side = 0; side < 2; ++side) {
+        int weak = 1 - side;
+        const int* own = count + side * 6;
+
+        if (pawns[weak] + nonPawn[weak] == 0) {
+            entry.strongSide = side;
+            if (pawns[side] == 0 && majors[side] == 0 && own[1] == 1 && own[2] == 1) {
+                entry.evaluation = evaluateKBNK;
+                return entry;
+            }
+            if (nonPawn[side] >= MG_VALUE[3]) {
+                entry.evaluation = evaluateKXK;
+                return entry;
+            }
+        }
+
+        if (pawns[side] == 0 && minors[side] == 0 && own[3] == 1 && own[4] == 0 &&
+            pawns[weak] == 1 && nonPawn[weak] == 0) {
+            entry.strongSide = side;
+            entry.evaluation = evaluateKRKP;
+            return entry;
+        }
+    }
+
+    if (count[2] == 1 && count[8] == 1) {
+        entry.scale[0] = scaleOppositeBishops;
+        entry.scale[1] = scaleOppositeBishops;
+    }
+
+    // Hard to win without pawns and less than a bishop ahead
+    for (int side = 0; side < 2; ++side) {
+        int weak = 1 - side;
+        if (nonPawn[side] - nonPawn[weak] > MG_VALUE[2])
+            continue;
+        if (pawns[side] == 0)
+            entry.factor[side] = nonPawn[side] < MG_VALUE[3] ? SCALE_DRAW : (nonPawn[weak] <= MG_VALUE[2] ? 4 : 14);
+        else if (pawns[side] == 1)
+            entry.factor[side] = SCALE_ONE_PAWN;
+    }
+
+    return entry;
+}
+
+
+MaterialTable::MaterialTable() : entries(MATERIAL_HASH_SIZE) {
+    clear();
+}
+
+void MaterialTable::clear() {
+    for (MaterialEntry& entry : entries)
+        entry = MaterialEntry();
+    probes = 0;
+    hits = 0;
+}
+
+const MaterialEntry& MaterialTable::probe(uint64_t key) {
+    probes++;
+    // The counts are in the low bits : mixed before taking the index
+    MaterialEntry& entry = entries[((key * 0x9E3779B97F4A7C15ULL) >> 32) & (MATERIAL_HASH_SIZE - 1)];
+
+    if (entry.key == key) {
+        hits++;
+        return entry;
+    }
+
+    entry = computeMaterial(key);
+    return entry;
+}
@@ -0,0 +1,291 @@
+#include "Headers/NNUE.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NNUE_X86 1
+#endif
+
+// Network file : "CNUE", version, dimensions, then the little-endian arrays in the order of the class
+struct NNUEHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t inputs;
+    uint32_t l1;
+    uint32_t l2;
+    uint32_t l3;
+};
+
+
+// Index of a feature seen from a side : Black sees the board upside down with the colors swapped
+static inline int featureIndex(int perspective, int kingSquare, int piece, int square) {
+    if (perspective == 1) {
+        kingSquare ^= 56;
+        square ^= 56;
+        piece = piece < 6 ? piece + 6 : piece - 6;
+    }
+    int pieceIndex = (piece % 6) + (piece < 6 ? 0 : 5); // Own pieces 0..4, enemy pieces 5..9
+    return kingSquare * NNUE_PIECE_SQUARES + pieceIndex * 64 + square;
+}
+
+static inline bool isKing(int piece) {
+    return piece == 5 || piece == 11;
+}
+
+
+// ════════════════════════════════════════════════════════
+// SCALAR KERNELS
+// ════════════════════════════════════════════════════════
+
+static void addWeightsScalar(int16_t* values, const int16_t* weights) {
+    for (int i = 0; i < NNUE_L1; ++i)
+        values[i] += weights[i];
+}
+
+static void subWeightsScalar(int16_t* values, const int16_t* weights) {
+    for (int i = 0; i < NNUE_L1; ++i)
+        values[i] -= weights[i];
+}
+
+static void clipAccumulatorScalar(const int16_t* values, uint8_t* output) {
+    for (int i = 0; i < NNUE_L1; ++i)
+        output[i] = static_cast<uint8_t>(std::min<int>(std::max<int>(values[i], 0), 127));
+}
+
+static int32_t dotScalar(const uint8_t* input, const int8_t* weights, int size) {
+    int32_t sum = 0;
+    for (int i = 0; i < size; ++i)
+        sum += input[i] * weights[i];
+    return sum;
+}
+
+
+// ════════════════════════════════════════════════════════
+// AVX2 KERNELS
+// ════════════════════════════════════════════════════════
+
+#ifdef NNUE_X86
+
+__attribute__((target("avx2")))
+static void addWeightsAvx2(int16_t* values, const int16_t* weights) {
+    for (int i = 0; i < NNUE_L1; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), _mm256_add_epi16(v, w));
+    }
+}
+
+__attribute__((target("avx2")))
+static void subWeightsAvx2(int16_t* values, const int16_t* weights) {
+    for (int i = 0; i < NNUE_L1; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(values + i), _mm256_sub_epi16(v, w));
+    }
+}
+
+__attribute__((target("avx2")))
+static void clipAccumulatorAvx2(const int16_t* values, uint8_t* output) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (int i = 0; i < NNUE_L1; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i + 16));
+        // packs works on 128 bits lanes : put the 4 quarters back in order
+        __m256i packed = _mm256_max_epi8(_mm256_packs_epi16(a, b), zero);
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), packed);
+    }
+}
+
+__attribute__((target("avx2")))
+static int32_t dotAvx2(const uint8_t* input, const int8_t* weights, int size) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i sum = _mm256_setzero_si256();
+    for (int i = 0; i < size; i += 32) {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights + i));
+        // inputs <= 127 : the pairs of products can't saturate 16 bits
+        __m256i products = _mm256_madd_epi16(_mm256_maddubs_epi16(in, w), ones);
+        sum = _mm256_add_epi32(sum, products);
+    }
+    __m128i low = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    low = _mm_add_epi32(low, _mm_shuffle_epi32(low, 0x4E));
+    low = _mm_add_epi32(low, _mm_shuffle_epi32(low, 0xB1));
+    return _mm_cvtsi128_si32(low);
+}
+
+#endif
+
+
+NNUE::NNUE() {
+#ifdef NNUE_X86
+    useAvx2 = __builtin_cpu_supports("avx2");
+#endif
+}
+
+
+template <typename T>
+static bool readArray(std::ifstream& file, std::vector<T>& array, size_t size) {
+    array.resize(size);
+    file.read(reinterpret_cast<char*>(array.data()), size * sizeof(T));
+    return static_cast<size_t>(file.gcount()) == size * sizeof(T);
+}
+
+bool NNUE::load(const std::string& path) {
+    loaded = false;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "NNUE: unable to open " << path << std::endl;
+        return false;
+    }
+
+    NNUEHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (file.gcount() != sizeof(header) || std::memcmp(header.magic, "CNUE", 4) != 0) {
+        std::cerr << "NNUE: " << path << " is not a network file" << std::endl;
+        return false;
+    }
+    if (header.version != NNUE_VERSION) {
+        std::cerr << "NNUE: version " << header.version << " not supported (expected " << NNUE_VERSION << ")" << std::endl;
+        return false;
+    }
+    if (header.inputs != NNUE_INPUTS || header.l1 != NNUE_L1 || header.l2 != NNUE_L2 || header.l3 != NNUE_L3) {
+        std::cerr << "NNUE: " << path << " has an other architecture" << std::endl;
+        return false;
+    }
+
+    bool ok = readArray(file, featureBiases, NNUE_L1) &&
+              readArray(file, featureWeights, static_cast<size_t>(NNUE_INPUTS) * NNUE_L1) &&
+              readArray(file, l1Biases, NNUE_L2) &&
+              readArray(file, l1Weights, NNUE_L2 * 2 * NNUE_L1) &&
+              readArray(file, l2Biases, NNUE_L3) &&
+              readArray(file, l2Weights, NNUE_L3 * NNUE_L2);
+
+    file.read(reinterpret_cast<char*>(&outputBias), sizeof(outputBias));
+    ok = ok && file.gcount() == sizeof(outputBias) && readArray(file, outputWeights, NNUE_L3);
+
+    // Nothing should be left
+    ok = ok && file.peek() == std::ifstream::traits_type::eof();
+
+    if (!ok) {
+        std::cerr << "NNUE: " << path << " is truncated or too long" << std::endl;
+        return false;
+    }
+
+    loaded = true;
+    return true;
+}
+
+
+void NNUE::refresh(Accumulator& accumulator, const uint64_t* bitboards, int perspective) const {
+    int16_t* values = accumulator.values[perspective];
+    std::memcpy(values, featureBiases.data(), sizeof(int16_t) * NNUE_L1);
+
+    int kingSquare = __builtin_ctzll(bitboards[perspective == 0 ? 5 : 11]);
+
+    for (int piece = 0; piece < 12; ++piece) {
+        if (isKing(piece))
+            continue;
+
+        uint64_t bitboard = bitboards[piece];
+        while (bitboard) {
+            int square = __builtin_ctzll(bitboard);
+            const int16_t* weights = &featureWeights[static_cast<size_t>(featureIndex(perspective, kingSquare, piece, square)) * NNUE_L1];
+#ifdef NNUE_X86
+            if (useAvx2)
+                addWeightsAvx2(values, weights);
+            else
+#endif
+                addWeightsScalar(values, weights);
+            bitboard &= bitboard - 1;
+        }
+    }
+
+    accumulator.computed[perspective] = true;
+}
+
+
+// The king of this side didn't move : only the pieces of the dirty list change
+void NNUE::update(const Accumulator& parent, Accumulator& accumulator, const uint64_t* bitboards, int perspective) const {
+    int16_t* values = accumulator.values[perspective];
+    std::memcpy(values, parent.values[perspective], sizeof(int16_t) * NNUE_L1);
+
+    int kingSquare = __builtin_ctzll(bitboards[perspective == 0 ? 5 : 11]);
+
+    for (int i = 0; i < accumulator.dirtyCount; ++i) {
+        const DirtyPiece& dirty = accumulator.dirty[i];
+        if (isKing(dirty.piece))
+            continue;
+
+        if (dirty.from != -1) {
+            const int16_t* weights = &featureWeights[static_cast<size_t>(featureIndex(perspective, kingSquare, dirty.piece, dirty.from)) * NNUE_L1];
+#ifdef NNUE_X86
+            if (useAvx2)
+                subWeightsAvx2(values, weights);
+            else
+#endif
+                subWeightsScalar(values, weights);
+        }
+
+        if (dirty.to != -1) {
+            const int16_t* weights = &featureWeights[static_cast<size_t>(featureIndex(perspective, kingSquare, dirty.piece, dirty.to)) * NNUE_L1];
+#ifdef NNUE_X86
+            if (useAvx2)
+                addWeightsAvx2(values, weights);
+            else
+#endif
+                addWeightsScalar(values, weights);
+        }
+    }
+
+    accumulator.computed[perspective] = true;
+}
+
+
+int NNUE::evaluate(const Accumulator& accumulator) const {
+    alignas(32) uint8_t input[2 * NNUE_L1];
+    alignas(32) uint8_t hidden1[NNUE_L2];
+    alignas(32) uint8_t hidden2[NNUE_L3];
+
+#ifdef NNUE_X86
+    if (useAvx2) {
+        clipAccumulatorAvx2(accumulator.values[0], input);
+        clipAccumulatorAvx2(accumulator.values[1], input + NNUE_L1);
+    } else
+#endif
+    {
+        clipAccumulatorScalar(accumulator.values[0], input);
+        clipAccumulatorScalar(accumulator.values[1], input + NNUE_L1);
+    }
+
+    for (int i = 0; i < NNUE_L2; ++i) {
+        const int8_t* weights = &l1Weights[i * 2 * NNUE_L1];
+        int32_t sum;
+#ifdef NNUE_X86
+        if (useAvx2)
+            sum = dotAvx2(input, weights, 2 * NNUE_L1);
+        else
+#endif
+            sum = dotScalar(input, weights, 2 * NNUE_L1);
+        hidden1[i] = static_cast<uint8_t>(std::min(std::max((l1Biases[i] + sum) >> NNUE_WEIGHT_SHIFT, 0), 127));
+    }
+
+    for (int i = 0; i < NNUE_L3; ++i) {
+        const int8_t* weights = &l2Weights[i * NNUE_L2];
+        int32_t sum;
+#ifdef NNUE_X86
+        if (useAvx2)
+            sum = dotAvx2(hidden1, weights, NNUE_L2);
+        else
+#endif
+            sum = dotScalar(hidden1, weights, NNUE_L2);
+        hidden2[i] = static_cast<uint8_t>(std::min(std::max((l2Biases[i] + sum) >> NNUE_WEIGHT_SHIFT, 0), 127));
+    }
+
+    int32_t output = outputBias + dotScalar(hidden2, outputWeights.data(), NNUE_L3);
+    return output / NNUE_OUTPUT_SCALE;
+}
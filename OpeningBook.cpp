@@ -0,0 +1,122 @@
+#include "Headers/OpeningBook.h"
+#include <fstream>
+#include <iostream>
+
+constexpr size_t BOOK_ENTRY_SIZE = 16;
+
+
+static bool loadRandoms(const std::string& path, std::vector<uint64_t>& randoms) {
+    std::ifstream file(path);
+    if (!file)
+        return false;
+
+    // Any separator is accepted ("0x9D39247E33776D41," as in the C sources)
+    randoms.clear();
+    std::string token;
+    while (file >> token && randoms.size() < POLYGLOT_RANDOM_COUNT) {
+        size_t start = token.find("0x");
+        if (start == std::string::npos)
+            start = token.find("0X");
+        if (start == std::string::npos)
+            continue;
+        randoms.push_back(std::stoull(token.substr(start + 2), nullptr, 16));
+    }
+    return randoms.size() == POLYGLOT_RANDOM_COUNT;
+}
+
+// Starting position : pieces on the first and last ranks, pawns on the second and seventh, the 4 castling
+// rights and White to move. Kinds of Polyglot : 2 * (PieceType % 6) for Black, + 1 for White.
+static uint64_t startKey(const std::vector<uint64_t>& randoms) {
+    static const int BACK_RANK[8] = {3, 1, 2, 4, 5, 2, 1, 3}; // Rook, knight, bishop, queen, king...
+    uint64_t key = 0;
+    for (int file = 0; file < 8; ++file) {
+        int kind = 2 * BACK_RANK[file];
+        key ^= randoms[64 * (kind + 1) + file] ^ randoms[64 * kind + 56 + file];
+        key ^= randoms[64 + 8 + file] ^ randoms[48 + file];
+    }
+    for (int i = 0; i < 4; ++i)
+        key ^= randoms[POLYGLOT_CASTLING + i];
+    return key ^ randoms[POLYGLOT_TURN];
+}
+
+bool OpeningBook::open(const std::string& bookPath) {
+    close();
+
+    size_t slash = bookPath.find_last_of("/\\");
+    std::string randomPath = (slash == std::string::npos ? "" : bookPath.substr(0, slash + 1)) + POLYGLOT_RANDOM_FILE;
+    if (!loadRandoms(randomPath, randoms)) {
+        std::cerr << "Book: " << randomPath << " must hold the " << POLYGLOT_RANDOM_COUNT << " Polyglot random numbers" << std::endl;
+        return false;
+    }
+    if (startKey(randoms) != POLYGLOT_START_KEY) {
+        std::cerr << "Book: " << randomPath << " doesn't give the Polyglot key of the starting position" << std::endl;
+        randoms.clear();
+        return false;
+    }
+
+    if (!file.open(bookPath)) {
+        std::cerr << "Book: unable to open " << bookPath << std::endl;
+        return false;
+    }
+
+    entryCount = file.size() / BOOK_ENTRY_SIZE;
+    return true;
+}
+
+void OpeningBook::close() {
+    file.close();
+    entryCount = 0;
+}
+
+uint64_t OpeningBook::keyAt(size_t index) const {
+    const unsigned char* bytes = file.bytes() + index * BOOK_ENTRY_SIZE;
+    uint64_t key = 0;
+    for (int i = 0; i < 8; ++i)
+        key = (key << 8) | bytes[i];
+    return key;
+}
+
+uint16_t OpeningBook::read16(size_t offset) const {
+    const unsigned char* bytes = file.bytes() + offset;
+    return static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+}
+
+bool OpeningBook::probe(uint64_t key, uint16_t& move) {
+    if (!file.isOpen())
+        return false;
+
+    // First entry with this key
+    size_t low = 0, high = entryCount;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (keyAt(middle) < key)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    uint32_t totalWeight = 0;
+    size_t end = low;
+    for (; end < entryCount && keyAt(end) == key; ++end)
+        totalWeight += read16(end * BOOK_ENTRY_SIZE + 10);
+
+    if (end == low)
+        return false;
+
+    // Entries of weight 0 are only played when all of them are 0
+    if (totalWeight == 0) {
+        move = read16((low + rng() % (end - low)) * BOOK_ENTRY_SIZE + 8);
+        return true;
+    }
+
+    uint32_t choice = rng() % totalWeight;
+    for (size_t i = low; i < end; ++i) {
+        uint16_t weight = read16(i * BOOK_ENTRY_SIZE + 10);
+        if (choice < weight) {
+            move = read16(i * BOOK_ENTRY_SIZE + 8);
+            return true;
+        }
+        choice -= weight;
+    }
+    return false;
+}
@@ -0,0 +1,100 @@
+#include "Headers/PawnStructure.h"
+#include "Headers/Bitboard.h"
+#include "Headers/EvalTrace.h"
+
+static inline uint64_t adjacentFiles(uint64_t files) {
+    return eastOne(files) | westOne(files);
+}
+
+
+PawnEntry evaluatePawnStructure(uint64_t whitePawns, uint64_t blackPawns, EvalTrace* trace) {
+    PawnEntry entry;
+
+    entry.attacks[0] = whitePawnAttacks(whitePawns);
+    entry.attacks[1] = blackPawnAttacks(blackPawns);
+    entry.attackSpans[0] = northFill(entry.attacks[0]);
+    entry.attackSpans[1] = southFill(entry.attacks[1]);
+
+    // Squares in front of the pawns, on their file
+    uint64_t whiteFrontSpan = northFill(whitePawns << 8);
+    uint64_t blackFrontSpan = southFill(blackPawns >> 8);
+
+    // Passed : no enemy pawn in front, on the same file or next to it
+    entry.passed[0] = whitePawns & ~(blackFrontSpan | entry.attackSpans[1]);
+    entry.passed[1] = blackPawns & ~(whiteFrontSpan | entry.attackSpans[0]);
+
+    // Doubled : an other pawn of the same color behind it
+    uint64_t whiteDoubled = whitePawns & northFill(whitePawns << 8);
+    uint64_t blackDoubled = blackPawns & southFill(blackPawns >> 8);
+
+    // Isolated : no pawn of the same color on the next files
+    uint64_t whiteIsolated = whitePawns & ~adjacentFiles(fileFill(whitePawns));
+    uint64_t blackIsolated = blackPawns & ~adjacentFiles(fileFill(blackPawns));
+
+    // Backward : can't move forward safely and can never be defended by an other pawn
+    uint64_t whiteBackward = ((whitePawns << 8) & entry.attacks[1] & ~entry.attackSpans[0]) >> 8;
+    uint64_t blackBackward = ((blackPawns >> 8) & entry.attacks[0] & ~entry.attackSpans[1]) << 8;
+
+    int doubled = __builtin_popcountll(whiteDoubled) - __builtin_popcountll(blackDoubled);
+    int isolated = __builtin_popcountll(whiteIsolated) - __builtin_popcountll(blackIsolated);
+    int backward = __builtin_popcountll(whiteBackward) - __builtin_popcountll(blackBackward);
+
+    entry.mg += DOUBLED_PAWN_MG * doubled + ISOLATED_PAWN_MG * isolated + BACKWARD_PAWN_MG * backward;
+    entry.eg += DOUBLED_PAWN_EG * doubled + ISOLATED_PAWN_EG * isolated + BACKWARD_PAWN_EG * backward;
+
+    if (trace) {
+        trace->add(PARAM_DOUBLED_PAWN, doubled);
+        trace->add(PARAM_ISOLATED_PAWN, isolated);
+        trace->add(PARAM_BACKWARD_PAWN, backward);
+    }
+
+    uint64_t passed = entry.passed[0];
+    while (passed) {
+        int rank = __builtin_ctzll(passed) >> 3;
+        entry.mg += PASSED_PAWN_MG[rank];
+        entry.eg += PASSED_PAWN_EG[rank];
+        if (trace)
+            trace->add(PARAM_PASSED_PAWN + rank, 1);
+        passed &= passed - 1;
+    }
+
+    passed = entry.passed[1];
+    while (passed) {
+        int rank = 7 - (__builtin_ctzll(passed) >> 3);
+        entry.mg -= PASSED_PAWN_MG[rank];
+        entry.eg -= PASSED_PAWN_EG[rank];
+        if (trace)
+            trace->add(PARAM_PASSED_PAWN + rank, -1);
+        passed &= passed - 1;
+    }
+
+    return entry;
+}
+
+
+PawnHashTable::PawnHashTable() : entries(PAWN_HASH_SIZE) {
+    clear();
+}
+
+void PawnHashTable::clear() {
+    for (PawnEntry& entry : entries)
+        entry = PawnEntry();
+    // Key 0 (no pawns) must not be found in an empty entry
+    entries[0].key = 1;
+    probes = 0;
+    hits = 0;
+}
+
+const PawnEntry& PawnHashTable::probe(uint64_t key, uint64_t whitePawns, uint64_t blackPawns) {
+    probes++;
+    PawnEntry& entry = entries[key & (PAWN_HASH_SIZE - 1)];
+
+    if (entry.key == key) {
+        hits++;
+        return entry;
+    }
+
+    entry = evaluatePawnStructure(whitePawns, blackPawns);
+    entry.key = key;
+    return entry;
+}
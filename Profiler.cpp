@@ -0,0 +1,44 @@
+#include "Headers/Profiler.h"
+#include <iomanip>
+#include <sstream>
+
+#ifdef PROFILE_ZONES
+thread_local ProfileCounters profileCounters;
+#endif
+
+const char* profileZoneName(ProfileZone zone) {
+    switch (zone) {
+        case ZONE_SEARCH: return "search";
+        case ZONE_MOVE_GENERATION: return "move generation";
+        case ZONE_IS_IN_CHECK: return "isInCheck";
+        case ZONE_MAKE_MOVE: return "makeMove";
+        case ZONE_UNMAKE_MOVE: return "unMakeMove";
+        case ZONE_UPDATE_HASH: return "updateHash";
+        case ZONE_EVALUATION: return "evaluation";
+        case ZONE_MOVE_ORDERING: return "move ordering";
+        default: return "?";
+    }
+}
+
+// The self column adds up to 100 % : where the cycles really go
+std::string profileReport(const ProfileCounters& counters) {
+    double total = static_cast<double>(counters.zones[ZONE_SEARCH].cycles);
+    if (total == 0)
+        for (const ZoneCounters& zone : counters.zones)
+            total += zone.selfCycles;
+
+    std::ostringstream out;
+    out << std::fixed << std::setprecision(1);
+    out << std::left << std::setw(18) << "zone" << std::right << std::setw(12) << "calls" << std::setw(12) << "Mcycles"
+        << std::setw(9) << "total %" << std::setw(9) << "self %" << std::setw(14) << "cycles/call" << "\n";
+    for (int i = 0; i < ZONE_COUNT; ++i) {
+        const ZoneCounters& zone = counters.zones[i];
+        out << std::left << std::setw(18) << profileZoneName(static_cast<ProfileZone>(i)) << std::right
+            << std::setw(12) << zone.calls
+            << std::setw(12) << zone.cycles / 1e6
+            << std::setw(9) << (total > 0 ? 100 * zone.cycles / total : 0)
+            << std::setw(9) << (total > 0 ? 100 * zone.selfCycles / total : 0)
+            << std::setw(14) << (zone.calls > 0 ? static_cast<double>(zone.cycles) / zone.calls : 0) << "\n";
+    }
+    return out.str();
+}
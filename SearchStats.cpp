@@ -0,0 +1,73 @@
+#include "Headers/SearchStats.h"
+#include "Headers/chessboard.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+int64_t SearchStats::nps() const {
+    return searchSeconds > 0 ? static_cast<int64_t>(nodes / searchSeconds) : 0;
+}
+
+double SearchStats::firstMoveCutoffRate() const {
+    return betaCutoffs > 0 ? static_cast<double>(firstMoveCutoffs) / betaCutoffs : 0;
+}
+
+double SearchStats::branchingFactor() const {
+    return depth > 0 && nodes > 0 ? std::pow(static_cast<double>(nodes), 1.0 / depth) : 0;
+}
+
+// A mate found at ply p scores MATE_SCORE + depth - p (quiescence mates count as found at the last ply)
+int SearchStats::mateIn() const {
+    if (std::abs(score) < MATE_SCORE)
+        return 0;
+    int plies = std::max(1, depth - (std::abs(score) - MATE_SCORE));
+    bool winning = white ? score > 0 : score < 0;
+    return winning ? (plies + 1) / 2 : -(plies / 2);
+}
+
+std::string SearchStats::toInfo() const {
+    std::ostringstream out;
+    out << "info depth " << depth;
+    if (mateIn() != 0)
+        out << " score mate " << mateIn();
+    else
+        out << " score cp " << (white ? score : -score);
+    out << " nodes " << nodes
+        << " nps " << nps() << " time " << static_cast<int64_t>(searchSeconds * 1000);
+    if (!bestMove.empty())
+        out << " pv " << bestMove;
+    out << "\n";
+
+    out.precision(3);
+    out << "info string qnodes " << qnodes << " ebf " << branchingFactor() << " fmc " << firstMoveCutoffRate()
+        << " tt " << ttProbes << "/" << ttHits << "/" << ttCutoffs << "/" << ttStores << "/" << ttOverwrites
+        << " (probes/hits/cutoffs/stores/overwrites, size " << ttSize << ")"
+        << " eval " << evalProbes << "/" << evalHits << "/" << evalCollisions << " bitbase " << bitbaseProbes << "\n";
+    out << "info string pruning draw " << drawCutoffs << " bitbase " << bitbaseCutoffs << " rfp " << reverseFutility
+        << " razor " << razoring << " futility " << futility << " null " << nullMove << " probcut " << probCut
+        << " multicut " << multiCut << " lmr " << lmrReductions << " lmr_research " << lmrResearches
+        << " total_time " << static_cast<int64_t>(totalSeconds * 1000);
+    return out.str();
+}
+
+// Keys in snake case, times in milliseconds
+std::string SearchStats::toJson() const {
+    std::ostringstream out;
+    out << "{\"depth\":" << depth << ",\"side\":\"" << (white ? "white" : "black") << "\",\"score\":" << score
+        << ",\"best_move\":\"" << bestMove << "\"";
+    if (mateIn() != 0)
+        out << ",\"mate\":" << mateIn();
+    out << ",\"nodes\":" << nodes << ",\"qnodes\":" << qnodes << ",\"nps\":" << nps()
+        << ",\"ebf\":" << branchingFactor() << ",\"first_move_cutoff_rate\":" << firstMoveCutoffRate()
+        << ",\"beta_cutoffs\":" << betaCutoffs
+        << ",\"tt\":{\"probes\":" << ttProbes << ",\"hits\":" << ttHits << ",\"cutoffs\":" << ttCutoffs
+        << ",\"stores\":" << ttStores << ",\"overwrites\":" << ttOverwrites << ",\"size\":" << ttSize << "}"
+        << ",\"eval_cache\":{\"probes\":" << evalProbes << ",\"hits\":" << evalHits << ",\"collisions\":" << evalCollisions << "}"
+        << ",\"bitbase_probes\":" << bitbaseProbes
+        << ",\"pruning\":{\"draw\":" << drawCutoffs << ",\"bitbase\":" << bitbaseCutoffs
+        << ",\"reverse_futility\":" << reverseFutility << ",\"razoring\":" << razoring << ",\"futility\":" << futility
+        << ",\"null_move\":" << nullMove << ",\"probcut\":" << probCut << ",\"multicut\":" << multiCut
+        << ",\"lmr_reductions\":" << lmrReductions << ",\"lmr_researches\":" << lmrResearches << "}"
+        << ",\"time_ms\":{\"search\":" << searchSeconds * 1000 << ",\"total\":" << totalSeconds * 1000 << "}}";
+    return out.str();
+}
@@ -0,0 +1,366 @@
+// Retrograde analysis of KPK, KRK, KQK and KBNK, written for Bitbases (Headers/Bitbase.h).
+// Usage : bitbase_generator [directory] [--no-dtm]   (default : bitbases)
+//
+// Positions where the weak side is mated are won, then the wins go backward, one ply at a time :
+// - strong side to move : won if one move reaches a won position (one un-move from it is enough),
+// - weak side to move : won when all its moves reach won positions (a counter of moves left per position).
+// A weak king that can take a piece gets a draw. KPK promotions are read in KQK and KRK, generated before
+// (a rook wins some positions where a queen stalemates ; knights and bishops can't win alone).
+// Going ply by ply gives the distance to mate : written in .dtm files (1 byte per position) unless --no-dtm.
+
+#include "Headers/Bitbase.h"
+#include "Headers/Bitboard.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+enum PositionState : uint8_t { UNKNOWN, WIN, DRAW };
+
+struct Position {
+    bool strongToMove;
+    int strongKing;
+    int weakKing;
+    int squares[2];
+};
+
+static Position decode(uint32_t index, int pieceCount) {
+    Position position;
+    for (int i = pieceCount - 1; i >= 0; --i) {
+        position.squares[i] = index & 63;
+        index >>= 6;
+    }
+    position.weakKing = index & 63;
+    index >>= 6;
+    position.strongKing = index & 63;
+    index >>= 6;
+    position.strongToMove = index == 0;
+    return position;
+}
+
+static uint32_t encode(const Position& position, int pieceCount) {
+    return bitbaseIndex(position.strongToMove, position.strongKing, position.weakKing, position.squares, pieceCount);
+}
+
+static uint64_t pieceAttacks(int type, int square, uint64_t occupied) {
+    uint64_t bit = 1ULL << square;
+    switch (type) {
+        case 0: return whitePawnAttacks(bit);
+        case 1: return knightAttacks(bit);
+        case 2: return bishopAttacks(bit, ~occupied);
+        case 3: return rookAttacks(bit, ~occupied);
+        case 4: return bishopAttacks(bit, ~occupied) | rookAttacks(bit, ~occupied);
+        default: return 0;
+    }
+}
+
+
+class Generator {
+    public:
+        Generator(int table, const Generator* queen = nullptr, const Generator* rook = nullptr)
+            : table(table), pieceCount(BITBASE_INFO[table].pieceCount), pieces(BITBASE_INFO[table].pieces),
+              size(bitbaseSize(table)), state(size, UNKNOWN), distance(size, 0), movesLeft(size / 2, 0),
+              queen(queen), rook(rook) {}
+
+        void run();
+        uint32_t wins() const;
+        bool write(const std::string& path) const;
+        bool writeDistances(const std::string& path) const;
+
+    private:
+        int table;
+        int pieceCount;
+        const int* pieces;
+        uint32_t size;
+        std::vector<uint8_t> state;
+        std::vector<uint8_t> distance;  // Plies to mate of the won positions
+        std::vector<uint8_t> movesLeft; // Weak side to move, indexed by index - size / 2
+        std::vector<std::vector<uint32_t>> wonAt;     // Won positions by distance, their predecessors are not seen yet
+        std::vector<std::vector<uint32_t>> promotions; // KPK : won through KQK or KRK, only sure once the shorter wins are known
+        const Generator* queen;
+        const Generator* rook;
+
+        uint64_t occupancy(const Position& position) const {
+            uint64_t occupied = (1ULL << position.strongKing) | (1ULL << position.weakKing);
+            for (int i = 0; i < pieceCount; ++i)
+                occupied |= 1ULL << position.squares[i];
+            return occupied;
+        }
+
+        // skip = index of a piece taken by the weak king
+        uint64_t strongAttacks(const Position& position, uint64_t occupied, int skip = -1) const {
+            uint64_t attacks = kingAttacks(1ULL << position.strongKing);
+            for (int i = 0; i < pieceCount; ++i)
+                if (i != skip)
+                    attacks |= pieceAttacks(pieces[i], position.squares[i], occupied);
+            return attacks;
+        }
+
+        bool isValid(const Position& position) const;
+        void initialize(uint32_t index);
+        void markWin(uint32_t index, int plies);
+        void strongPredecessors(const Position& position, int plies);
+        void weakPredecessors(const Position& position, int plies);
+};
+
+bool Generator::isValid(const Position& position) const {
+    uint64_t occupied = occupancy(position);
+    if (__builtin_popcountll(occupied) != 2 + pieceCount)
+        return false;
+    if (kingAttacks(1ULL << position.strongKing) & (1ULL << position.weakKing))
+        return false;
+    for (int i = 0; i < pieceCount; ++i)
+        if (pieces[i] == 0 && (position.squares[i] < 8 || position.squares[i] >= 56))
+            return false;
+    // The side that just moved can't be in check
+    if (position.strongToMove && (strongAttacks(position, occupied) & (1ULL << position.weakKing)))
+        return false;
+    return true;
+}
+
+void Generator::markWin(uint32_t index, int plies) {
+    if (plies >= static_cast<int>(wonAt.size()))
+        wonAt.resize(plies + 1);
+    state[index] = WIN;
+    distance[index] = static_cast<uint8_t>(plies);
+    wonAt[plies].push_back(index);
+}
+
+void Generator::initialize(uint32_t index) {
+    Position position = decode(index, pieceCount);
+    if (!isValid(position)) {
+        state[index] = DRAW;
+        return;
+    }
+
+    uint64_t occupied = occupancy(position);
+
+    if (position.strongToMove) {
+        // KPK : a promotion that wins in KQK or KRK, the shortest mate of the two
+        for (int i = 0; i < pieceCount; ++i) {
+            int to = position.squares[i] + 8;
+            if (pieces[i] != 0 || to < 56 || (occupied & (1ULL << to)))
+                continue;
+            int promotedSquare[1] = {to};
+            uint32_t promotedIndex = bitbaseIndex(false, position.strongKing, position.weakKing, promotedSquare, 1);
+            int plies = -1;
+            for (const Generator* promoted : {queen, rook})
+                if (promoted->state[promotedIndex] == WIN && (plies == -1 || promoted->distance[promotedIndex] + 1 < plies))
+                    plies = promoted->distance[promotedIndex] + 1;
+            if (plies != -1) {
+                if (plies >= static_cast<int>(promotions.size()))
+                    promotions.resize(plies + 1);
+                promotions[plies].push_back(index);
+            }
+        }
+        return;
+    }
+
+    // Weak side to move : count its legal moves
+    uint64_t withoutKing = occupied & ~(1ULL << position.weakKing);
+    uint64_t targets = kingAttacks(1ULL << position.weakKing) & ~kingAttacks(1ULL << position.strongKing);
+    int count = 0;
+
+    while (targets) {
+        int to = __builtin_ctzll(targets);
+        targets &= targets - 1;
+
+        int taken = -1;
+        for (int i = 0; i < pieceCount; ++i)
+            if (position.squares[i] == to)
+                taken = i;
+
+        if (taken != -1) {
+            // Not defended : the piece is lost, draw
+            if (!(strongAttacks(position, withoutKing, taken) & (1ULL << to))) {
+                state[index] = DRAW;
+                return;
+            }
+        } else if (!(strongAttacks(position, withoutKing) & (1ULL << to))) {
+            count++;
+        }
+    }
+
+    if (count == 0) {
+        bool inCheck = strongAttacks(position, occupied) & (1ULL << position.weakKing);
+        if (inCheck)
+            markWin(index, 0);
+        else
+            state[index] = DRAW; // Stalemate
+        return;
+    }
+
+    movesLeft[index - size / 2] = static_cast<uint8_t>(count);
+}
+
+// The weak side lost in position : every strong move that leads here wins
+void Generator::strongPredecessors(const Position& position, int plies) {
+    uint64_t occupied = occupancy(position);
+    Position previous = position;
+    previous.strongToMove = true;
+
+    uint64_t froms = kingAttacks(1ULL << position.strongKing) & ~occupied;
+    while (froms) {
+        previous.strongKing = __builtin_ctzll(froms);
+        froms &= froms - 1;
+        uint32_t index = encode(previous, pieceCount);
+        if (state[index] == UNKNOWN && isValid(previous))
+            markWin(index, plies + 1);
+    }
+    previous.strongKing = position.strongKing;
+
+    for (int i = 0; i < pieceCount; ++i) {
+        int square = position.squares[i];
+        uint64_t pieceFroms;
+        if (pieces[i] == 0) {
+            // Pawns go back : one square, or two to the second rank
+            pieceFroms = 0;
+            if (square >= 16 && !(occupied & (1ULL << (square - 8)))) {
+                pieceFroms |= 1ULL << (square - 8);
+                if (square >= 24 && square < 32 && !(occupied & (1ULL << (square - 16))))
+                    pieceFroms |= 1ULL << (square - 16);
+            }
+        } else {
+            // Knights and sliders move the same way backward
+            pieceFroms = pieceAttacks(pieces[i], square, occupied) & ~occupied;
+        }
+
+        while (pieceFroms) {
+            previous.squares[i] = __builtin_ctzll(pieceFroms);
+            pieceFroms &= pieceFroms - 1;
+            uint32_t index = encode(previous, pieceCount);
+            if (state[index] == UNKNOWN && isValid(previous))
+                markWin(index, plies + 1);
+        }
+        previous.squares[i] = square;
+    }
+}
+
+// The strong side wins in position : one less escape for the weak king that came here
+void Generator::weakPredecessors(const Position& position, int plies) {
+    uint64_t occupied = occupancy(position);
+    Position previous = position;
+    previous.strongToMove = false;
+
+    uint64_t froms = kingAttacks(1ULL << position.weakKing) & ~occupied & ~kingAttacks(1ULL << position.strongKing);
+    while (froms) {
+        previous.weakKing = __builtin_ctzll(froms);
+        froms &= froms - 1;
+        uint32_t index = encode(previous, pieceCount);
+        // 0 : already won by an other move (or no move at all)
+        if (state[index] != UNKNOWN || movesLeft[index - size / 2] == 0)
+            continue;
+        // The wins come by increasing distance : the last escape closed is the longest
+        if (--movesLeft[index - size / 2] == 0)
+            markWin(index, plies + 1);
+    }
+}
+
+void Generator::run() {
+    for (uint32_t index = 0; index < size; ++index)
+        initialize(index);
+
+    for (size_t plies = 0; plies < wonAt.size() || plies < promotions.size(); ++plies) {
+        if (plies < promotions.size())
+            for (uint32_t index : promotions[plies])
+                if (state[index] == UNKNOWN)
+                    markWin(index, static_cast<int>(plies));
+
+        if (plies >= wonAt.size())
+            continue;
+
+        // markWin only adds to the next distance : the list doesn't move while it is read
+        for (size_t i = 0; i < wonAt[plies].size(); ++i) {
+            Position position = decode(wonAt[plies][i], pieceCount);
+            if (position.strongToMove)
+                weakPredecessors(position, static_cast<int>(plies));
+            else
+                strongPredecessors(position, static_cast<int>(plies));
+        }
+        std::vector<uint32_t>().swap(wonAt[plies]);
+    }
+}
+
+uint32_t Generator::wins() const {
+    uint32_t count = 0;
+    for (uint8_t s : state)
+        count += s == WIN;
+    return count;
+}
+
+bool Generator::write(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t header[3] = {BITBASE_VERSION, static_cast<uint32_t>(table), static_cast<uint32_t>(pieceCount)};
+    file.write("CBBS", 4);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<uint8_t> bits(size / 8, 0);
+    for (uint32_t index = 0; index < size; ++index)
+        if (state[index] == WIN)
+            bits[index >> 3] |= 1 << (index & 7);
+    file.write(reinterpret_cast<const char*>(bits.data()), bits.size());
+    return static_cast<bool>(file);
+}
+
+// 0 : not won, else plies to mate + 1
+bool Generator::writeDistances(const std::string& path) const {
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    uint32_t header[3] = {BITBASE_VERSION, static_cast<uint32_t>(table), static_cast<uint32_t>(pieceCount)};
+    file.write("CDTM", 4);
+    file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+    std::vector<uint8_t> bytes(size, 0);
+    for (uint32_t index = 0; index < size; ++index)
+        if (state[index] == WIN)
+            bytes[index] = distance[index] + 1;
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    return static_cast<bool>(file);
+}
+
+
+int main(int argc, char** argv) {
+    std::string directory = "bitbases";
+    bool distances = true;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--no-dtm") == 0)
+            distances = false;
+        else
+            directory = argv[i];
+    }
+
+    // KQK and KRK first : KPK promotions need them
+    std::unique_ptr<Generator> queen = std::make_unique<Generator>(KQK);
+    std::unique_ptr<Generator> rook = std::make_unique<Generator>(KRK);
+    const int order[BITBASE_COUNT] = {KQK, KRK, KPK, KBNK};
+
+    for (int table : order) {
+        auto start = std::chrono::steady_clock::now();
+
+        std::unique_ptr<Generator> other;
+        Generator* generator = table == KQK ? queen.get() : table == KRK ? rook.get() : nullptr;
+        if (!generator) {
+            other = std::make_unique<Generator>(table, queen.get(), rook.get());
+            generator = other.get();
+        }
+        generator->run();
+
+        std::string path = directory + "/" + BITBASE_INFO[table].name;
+        if (!generator->write(path + ".bb") || (distances && !generator->writeDistances(path + ".dtm"))) {
+            std::cerr << "Bitbase: unable to write " << path << " (does the directory exist ?)" << std::endl;
+            return 1;
+        }
+
+        std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+        std::cout << BITBASE_INFO[table].name << " : " << generator->wins() << " wins / " << bitbaseSize(table)
+                  << " positions, " << time.count() << " s" << std::endl;
+    }
+    return 0;
+}
@@ -1,53 +1,349 @@
 #include "Headers/chessboard.h"
 #include "Headers/ZobristHashing.h"
+#include "Headers/Bitboard.h"
+#include "Headers/Cpu.h"
+#include "Headers/Profiler.h"
 #include <SFML/Graphics.hpp>
 #include <iostream>
 #include <map>
 #include <string>
 #include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <optional>
 
 ChessBoard::ChessBoard(int windowWidth, int windowHeight, int size, sf::RenderWindow& window)
-    : windowSize(windowWidth, windowHeight),
-      boardSize(size),
+    : boardSize(size),
+      windowSize(windowWidth, windowHeight),
       LIGHT_COLOR(223, 227, 185),
       DARK_COLOR(156, 125, 94),
-      zobrist(0x123456789ABCDEF0ULL),
+      window(window),
       currentHash(0ULL),
+      pawnHash(0ULL),
+      evalCache(EVAL_CACHE_SIZE),
       transpositionTable(),
-      hashHistory(),
-      window(window) {
+      states(STATE_STACK_SIZE) {
 
       
       squareSize = windowWidth / boardSize;
-      loadTextures();
-      currentHash = computeInitialHash();
+      if (window.isOpen()) // Tools like the tuner never open the window
+          loadTextures();
+      resetState(true);
+      initReductions();
 }
 
 
-uint64_t ChessBoard::computeInitialHash() {
+void ChessBoard::initReductions() {
+    // Late moves at high depth are reduced more : r = log(depth) * log(moveIndex) / 2
+    for (int depth = 0; depth < MAX_DEPTH; ++depth) {
+        for (int moveIndex = 0; moveIndex < MAX_MOVES; ++moveIndex) {
+            if (depth == 0 || moveIndex == 0)
+                lmrReductions[depth][moveIndex] = 0;
+            else
+                lmrReductions[depth][moveIndex] = static_cast<int>(0.5 + std::log(depth) * std::log(moveIndex) / 2.0);
+        }
+    }
+}
+
+
+// Side and en passant included : the keys of makeMove / makeNullMove give the same hash
+uint64_t ChessBoard::computeInitialHash(bool whiteToMove) {
 
     uint64_t hash = 0ULL;
 
     for (int i = 0; i < 64; ++i) {
         for (int pieceType = 0; pieceType < 12; ++pieceType) {
             if ((piece.bitboards[pieceType] >> i) & 1ULL) {
-                hash ^= zobrist.pieceSquare[pieceType][i];
+                hash ^= ZOBRIST.pieceSquare[pieceType][i];
                 break;
             }
         }
     }
 
-    // Castling
-    int num =  whiteKingSideCastling |
-          (whiteQueenSideCastling << 1) |
-          (blackKingSideCastling  << 2) |
-           (blackQueenSideCastling << 3);
+    hash ^= ZOBRIST.castlingRights[castlingRights];
+
+    hash ^= ZOBRIST.enPassant[enPassant + 1];
+    if (!whiteToMove)
+        hash ^= ZOBRIST.sideToMove;
+
+    return hash;
+}
+
+uint64_t ChessBoard::computeInitialPawnHash() {
+
+    uint64_t hash = 0ULL;
 
-    hash ^= zobrist.castlingRights[num];
+    for (int pieceType : {WHITE_PAWN, BLACK_PAWN}) {
+        uint64_t bitboard = piece.bitboards[pieceType];
+        while (bitboard) {
+            hash ^= ZOBRIST.pieceSquare[pieceType][__builtin_ctzll(bitboard)];
+            bitboard &= bitboard - 1;
+        }
+    }
 
     return hash;
 }
 
+// Key of the Polyglot books, with their own random numbers (only when a book is open). Built from the bitboards :
+// the book is only probed at the root of AI_chess, once per move of the game (about 40 XORs), while a key updated
+// next to currentHash would cost every makeMove of the search for nothing. The en passant key also depends
+// on a pawn being able to take, which updateHash doesn't look at.
+uint64_t ChessBoard::computePolyglotKey(bool whiteToMove) {
+
+    uint64_t key = 0ULL;
+
+    for (int pieceType = 0; pieceType < 12; ++pieceType) {
+        // Polyglot order : black pawn, white pawn, black knight, white knight...
+        int kind = pieceType < 6 ? 2 * pieceType + 1 : 2 * (pieceType - 6);
+        uint64_t bitboard = piece.bitboards[pieceType];
+        while (bitboard) {
+            key ^= book.random(64 * kind + __builtin_ctzll(bitboard));
+            bitboard &= bitboard - 1;
+        }
+    }
+
+    // Same order as the rights : white king side, white queen side, black king side, black queen side
+    for (int i = 0; i < 4; ++i)
+        if (castlingRights & (1 << i))
+            key ^= book.random(POLYGLOT_CASTLING + i);
+
+    // Only when a pawn can really take en passant
+    if (enPassant != -1) {
+        uint64_t target = 1ULL << enPassant;
+        uint64_t takers = whiteToMove ? (blackPawnAttacks(target) & piece.bitboards[WHITE_PAWN])
+                                      : (whitePawnAttacks(target) & piece.bitboards[BLACK_PAWN]);
+        if (takers)
+            key ^= book.random(POLYGLOT_EN_PASSANT + (enPassant & 7));
+    }
+
+    if (whiteToMove)
+        key ^= book.random(POLYGLOT_TURN);
+
+    return key;
+}
+
+EvalState ChessBoard::computeEvalState() {
+
+    EvalState state;
+
+    for (int pieceType = 0; pieceType < 12; ++pieceType) {
+        uint64_t bitboard = piece.bitboards[pieceType];
+        while (bitboard) {
+            state.add(pieceType, __builtin_ctzll(bitboard));
+            bitboard &= bitboard - 1;
+        }
+    }
+
+    return state;
+}
+
+// The first 4 fields are needed (position, side to move, castling, en passant), the halfmove clock is optional
+bool ChessBoard::loadFen(const std::string& fen, bool& whiteToMove) {
+    std::istringstream stream(fen);
+    std::string position, side, castling, enPassantSquare;
+    if (!(stream >> position >> side >> castling >> enPassantSquare))
+        return false;
+    int halfmoveClock = 0;
+    if (!(stream >> halfmoveClock))
+        halfmoveClock = 0;
+
+    const std::string pieceLetters = "PNBRQKpnbrqk"; // In the order of PieceType
+    uint64_t bitboards[12] = {};
+    int rank = 7;
+    int file = 0;
+    for (char c : position) {
+        if (c == '/') {
+            rank--;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+        } else {
+            size_t type = pieceLetters.find(c);
+            if (type == std::string::npos || rank < 0 || file > 7)
+                return false;
+            bitboards[type] |= 1ULL << (rank * 8 + file);
+            file++;
+        }
+    }
+    if (rank != 0 || __builtin_popcountll(bitboards[WHITE_KING]) != 1 || __builtin_popcountll(bitboards[BLACK_KING]) != 1)
+        return false;
+
+    for (int i = 0; i < 12; ++i)
+        piece.bitboards[i] = bitboards[i];
+
+    whiteToMove = side != "b";
+    castlingRights = 0;
+    for (int i = 0; i < 4; ++i)
+        if (castling.find("KQkq"[i]) != std::string::npos)
+            castlingRights |= 1 << i;
+    enPassant = enPassantSquare == "-" ? -1 : (enPassantSquare[0] - 'a') + 8 * (enPassantSquare[1] - '1');
+    rule50 = halfmoveClock;
+
+    resetState(whiteToMove);
+    return true;
+}
+
+// King and rook of a castling (castlingIndex, the bit of its right) still on their squares
+static bool castlingPiecesHome(const uint64_t* bitboards, int index) {
+    bool white = index < 2;
+    return (bitboards[white ? WHITE_KING : BLACK_KING] & (1ULL << (white ? 4 : 60))) &&
+           (bitboards[white ? WHITE_ROOK : BLACK_ROOK] & (1ULL << CASTLING_ROOK_FROM[index]));
+}
+
+// After the bitboards were changed by hand (FEN, edition of the board) : everything makeMove keeps up to date
+// is computed again, and the castling rights whose king or rook left its square are dropped
+void ChessBoard::resetState(bool whiteToMove) {
+    for (int i = 0; i < 4; ++i)
+        if (!castlingPiecesHome(piece.bitboards, i))
+            castlingRights &= ~(1 << i);
+
+    currentHash = computeInitialHash(whiteToMove);
+    pawnHash = computeInitialPawnHash();
+    evalState = computeEvalState();
+    statePly = 0; // The moves before can't be taken back
+    rootPly = 0;
+    pliesFromNull = 0;
+
+    if (nnue.isLoaded()) {
+        accumulatorPly = 0;
+        nnue.refresh(accumulators[0], piece.bitboards, 0);
+        nnue.refresh(accumulators[0], piece.bitboards, 1);
+    }
+}
+
+// Before a search : room for MAX_SEARCH_PLY plies above the game. The game moves before the last capture
+// or pawn move can't come back, they are the ones dropped (with the oldest of a very long shuffle).
+void ChessBoard::trimStates() {
+    if (statePly + MAX_SEARCH_PLY <= STATE_STACK_SIZE)
+        return;
+    int keep = std::min(rule50, STATE_STACK_SIZE / 2);
+    std::copy(states.begin() + (statePly - keep), states.begin() + statePly, states.begin());
+    statePly = keep;
+}
+
+Position ChessBoard::savePosition() const {
+    Position position;
+    for (int i = 0; i < 12; ++i)
+        position.bitboards[i] = piece.bitboards[i];
+    position.hash = currentHash;
+    position.pawnHash = pawnHash;
+    position.evalState = evalState;
+    position.enPassant = enPassant;
+    position.accumulatorPly = accumulatorPly;
+    position.rule50 = rule50;
+    position.pliesFromNull = pliesFromNull;
+    position.castling = castlingRights;
+    return position;
+}
+
+void ChessBoard::restorePosition(const Position& position) {
+    for (int i = 0; i < 12; ++i)
+        piece.bitboards[i] = position.bitboards[i];
+    currentHash = position.hash;
+    pawnHash = position.pawnHash;
+    evalState = position.evalState;
+    enPassant = position.enPassant;
+    accumulatorPly = position.accumulatorPly;
+    rule50 = position.rule50;
+    pliesFromNull = position.pliesFromNull;
+    castlingRights = position.castling;
+}
+
+BoardSnapshot ChessBoard::snapshot() const {
+    BoardSnapshot state;
+    state.position = savePosition();
+    state.statePly = statePly;
+    return state;
+}
+
+// Incremental state against the same state computed from the bitboards. error names what drifted.
+bool ChessBoard::verifyState(bool whiteToMove, std::string& error) {
+    const uint64_t* bitboards = piece.bitboards;
+
+    uint64_t occupied = 0;
+    for (int i = 0; i < 12; ++i) {
+        if (occupied & bitboards[i]) {
+            error = "two pieces on the same square";
+            return false;
+        }
+        occupied |= bitboards[i];
+    }
+    if (__builtin_popcountll(bitboards[WHITE_KING]) != 1 || __builtin_popcountll(bitboards[BLACK_KING]) != 1) {
+        error = "not one king of each color";
+        return false;
+    }
+    if ((bitboards[WHITE_PAWN] | bitboards[BLACK_PAWN]) & 0xFF000000000000FFULL) {
+        error = "pawn on the first or last rank";
+        return false;
+    }
+
+    // A right needs its king and its rook at home
+    for (int i = 0; i < 4; ++i) {
+        if ((castlingRights & (1 << i)) && !castlingPiecesHome(bitboards, i)) {
+            error = "castling right without its king or rook";
+            return false;
+        }
+    }
+
+    // En passant : empty square behind a pawn that just moved two squares
+    if (enPassant != -1) {
+        bool valid = whiteToMove ? (enPassant >> 3) == 5 && ((bitboards[BLACK_PAWN] >> (enPassant - 8)) & 1)
+                                 : (enPassant >> 3) == 2 && ((bitboards[WHITE_PAWN] >> (enPassant + 8)) & 1);
+        if (!valid || ((occupied >> enPassant) & 1)) {
+            error = "en passant square " + std::to_string(enPassant);
+            return false;
+        }
+    }
+
+    if (statePly < 0 || statePly >= STATE_STACK_SIZE || rule50 < 0) {
+        error = "state stack ply " + std::to_string(statePly);
+        return false;
+    }
+
+    if (currentHash != computeInitialHash(whiteToMove)) {
+        error = "hash";
+        return false;
+    }
+    if (pawnHash != computeInitialPawnHash()) {
+        error = "pawn hash";
+        return false;
+    }
+    if (!(evalState == computeEvalState())) {
+        error = "evaluation state";
+        return false;
+    }
+
+    // Only an accumulator already computed can be compared
+    if (nnue.isLoaded()) {
+        const Accumulator& accumulator = accumulators[accumulatorPly];
+        Accumulator fresh;
+        for (int perspective = 0; perspective < 2; ++perspective) {
+            if (!accumulator.computed[perspective])
+                continue;
+            nnue.refresh(fresh, bitboards, perspective);
+            if (std::memcmp(fresh.values[perspective], accumulator.values[perspective], sizeof(fresh.values[perspective])) != 0) {
+                error = "NNUE accumulator";
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+// Debug builds (VERIFY_STATE) : any drift stops the program where it happened
+void ChessBoard::checkState(bool whiteToMove, const char* where) {
+    std::string error;
+    if (!verifyState(whiteToMove, error)) {
+        std::cerr << where << ": incremental state differs from the board (" << error << ")" << std::endl;
+        std::abort();
+    }
+}
+
 void ChessBoard::loadTextures() {
 
     std::map<std::string, std::string> textureFiles = {
@@ -245,87 +541,74 @@ inline bool ChessBoard::isThereAPieceAt(int position) {
 }
 
 
-int ChessBoard::possibilityWhiteTower(int position, int* moves) {
-
-    int count = 0;
-
-    std::vector<int> directions = {1, - 1, 8, -8};
-
-    for (int direction : directions) {
-
-        for (int i = direction; ; i+= direction) {
-
-            if ((position + i) > 63) break; 
-            if ((position + i) < 0) break;
-
-            if ((((position + i) & 7) == 0) && (direction == 1))  break;
-            if ((((position + i) & 7) == 7) && (direction == -1)) break;
-
-            if (isThereAWhitePieceAt(position + i))
-                break;
+// The move generators are templates on the CpuLevel as the attack kernels (Attacks.cpp) : one wrapper per level
+// decides what the bit scans become, and BMI2 looks the sliders up with PEXT
 
-            moves[count++] = position + i;
-            if (isThereABlackPieceAt(position + i)) { 
-                break;
-                }
-        
-        }
+// Squares reached by a piece of the type (PieceType % 6, without the pawns) from the square
+template <CpuLevel level>
+KERNEL uint64_t pieceAttacksFrom(int type, int square, uint64_t occupied) {
+    uint64_t from = 1ULL << square;
+    switch (type) {
+        case 1: return knightAttacks(from);
+        case 2: return bishopAttacksOf<level>(from, occupied);
+        case 3: return rookAttacksOf<level>(from, occupied);
+        case 4: return bishopAttacksOf<level>(from, occupied) | rookAttacksOf<level>(from, occupied);
+        default: return kingAttacks(from);
     }
-
-    return count;
 }
 
-
-int ChessBoard::possibilityBlackTower(int position, int* moves) {
+// Targets of a slider in ascending order, the squares of its own side left out
+template <CpuLevel level>
+KERNEL int sliderMovesKernel(const uint64_t* bitboards, int square, PieceType type, int* moves) {
+    int us = type < 6 ? 0 : 6;
+    uint64_t own = 0, occupied = 0;
+    for (int i = 0; i < 12; ++i)
+        occupied |= bitboards[i];
+    for (int i = 0; i < 6; ++i)
+        own |= bitboards[us + i];
 
     int count = 0;
-    
+    for (uint64_t targets = pieceAttacksFrom<level>(type - us, square, occupied) & ~own; targets; targets &= targets - 1)
+        moves[count++] = __builtin_ctzll(targets);
+    return count;
+}
 
-    // Move right (+1)
-    for (int i = 1; ((position + i) & 7) != 0 && (position + i) < 64; i++) {
-        if (isThereABlackPieceAt(position + i))
-            break;
+static int sliderMovesGeneric(const uint64_t* bitboards, int square, PieceType type, int* moves) {
+    return sliderMovesKernel<CPU_GENERIC>(bitboards, square, type, moves);
+}
 
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
+#ifdef CPU_X86_64
 
-    // Move left (-1)
-    for (int i = -1; ((position + i) & 7) != 7 && (position + i) >= 0; i--) {
-        if (isThereABlackPieceAt(position + i))
-            break;
+__attribute__((target("popcnt")))
+static int sliderMovesPopcnt(const uint64_t* bitboards, int square, PieceType type, int* moves) {
+    return sliderMovesKernel<CPU_POPCNT>(bitboards, square, type, moves);
+}
 
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
+__attribute__((target("popcnt,bmi,bmi2")))
+static int sliderMovesBmi2(const uint64_t* bitboards, int square, PieceType type, int* moves) {
+    return sliderMovesKernel<CPU_BMI2>(bitboards, square, type, moves);
+}
 
-    // Move up (+8)
-    for (int i = 8; (position + i) < 64; i += 8) {
-        if (isThereABlackPieceAt(position + i))
-            break;
+#endif
 
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
+static int sliderMoves(const uint64_t* bitboards, int square, PieceType type, int* moves) {
+#ifdef CPU_X86_64
+    if (cpuLevel == CPU_BMI2)
+        return sliderMovesBmi2(bitboards, square, type, moves);
+    if (cpuLevel == CPU_POPCNT)
+        return sliderMovesPopcnt(bitboards, square, type, moves);
+#endif
+    return sliderMovesGeneric(bitboards, square, type, moves);
+}
 
-    // Move down (-8)
-    for (int i = -8; (position + i) >= 0; i -= 8) {
-        if (isThereABlackPieceAt(position + i))
-            break;
 
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
+int ChessBoard::possibilityWhiteTower(int position, int* moves) {
+    return sliderMoves(piece.bitboards, position, WHITE_ROOK, moves);
+}
 
-    return count;
+
+int ChessBoard::possibilityBlackTower(int position, int* moves) {
+    return sliderMoves(piece.bitboards, position, BLACK_ROOK, moves);
 }
 
 
@@ -466,107 +749,13 @@ int ChessBoard::possibilityBlackKnight(int position, int* moves) {
 
 
 int ChessBoard::possibilityWhiteBishop(int position, int* moves) {
-
-    int count = 0;
-
-    // Move up right (+9)
-    for (int i = 9; ((position + i) & 7) != 0 && (position + i) < 64; i+= 9) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move up left (+7)
-    for (int i = 7; (((position + i) & 7) != 7) && (position + i) < 64; i+= 7) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down right (-7)
-    for (int i = -7; (((position + i) & 7) != 0) && (position + i) >= 0; i-= 7) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down left (-9)
-    for (int i = -9; (((position + i) & 7) != 7) && (position + i) >= 0; i-= 9) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    return count;
+    return sliderMoves(piece.bitboards, position, WHITE_BISHOP, moves);
 }
 
 
 
 int ChessBoard::possibilityBlackBishop(int position, int* moves) {
-
-    int count = 0;
-    
-    // Move up right (+9)
-    for (int i = 9; (((position + i) & 7) != 0) && (position + i) < 64; i+= 9) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move up left (+7)
-    for (int i = 7; (((position + i) & 7) != 7) && (position + i) < 64; i+= 7) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down right (-7)
-    for (int i = -7; (((position + i) & 7) != 0) && (position + i) >= 0; i-= 7) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down left (-9)
-    for (int i = -9; (((position + i) & 7) != 7) && (position + i) >= 0; i-= 9) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    return count;
+    return sliderMoves(piece.bitboards, position, BLACK_BISHOP, moves);
 }
 
 
@@ -634,229 +823,41 @@ int ChessBoard::possibilityBlackPawn(int position, int* moves) {
 
  
 int ChessBoard::possibilityWhiteQueen(int position, int* moves) {
+    return sliderMoves(piece.bitboards, position, WHITE_QUEEN, moves);
+}
+
+
+
+int ChessBoard::possibilityBlackQueen(int position, int* moves) {
+    return sliderMoves(piece.bitboards, position, BLACK_QUEEN, moves);
+}
 
-    int count = 0;
 
-    // Like Bishop :
+int ChessBoard::possibilityWhiteKing(int position, int* moves) {
+
+    int count = 0;
 
     // Move up right (+9)
-    for (int i = 9; ((position + i) & 7) != 0 && (position + i) < 64; i+= 9) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
+    if (((position & 7) != 7) && (position + 9) < 64 && !isThereAWhitePieceAt(position + 9)) 
+        moves[count++] = position + 9;
 
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
 
     // Move up left (+7)
-    for (int i = 7; (((position + i) & 7) != 7) && (position + i) < 64; i+= 7) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
+    if ((position & 7) != 0 && (position + 7) < 64 &&  !isThereAWhitePieceAt(position + 7)) 
+        moves[count++] = position + 7;
 
     // Move down right (-7)
-    for (int i = -7; (((position + i) & 7) != 0) && (position + i) >= 0; i-= 7) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
+    if ((position & 7) != 7 && (position - 7) >= 0 &&  !isThereAWhitePieceAt(position - 7)) 
+        moves[count++] = position - 7;
 
     // Move down left (-9)
-    for (int i = -9; (((position + i) & 7) != 7) && (position + i) >= 0; i-= 9) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
+    if ((position & 7) != 0 && (position - 9) >= 0 &&  !isThereAWhitePieceAt(position - 9)) 
+        moves[count++] = position - 9;
 
-    // like Tower :
     // Move right (+1)
-    for (int i = 1; ((position + i) & 7) != 0 && (position + i) < 64; i++) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move left (-1)
-    for (int i = -1; ((position + i) & 7) != 7 && (position + i) >= 0; i--) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move up (+8)
-    for (int i = 8; (position + i) < 64; i += 8) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down (-8)
-    for (int i = -8; (position + i) >= 0; i -= 8) {
-        if (isThereAWhitePieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereABlackPieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    return count;
-}
-
-
-
-int ChessBoard::possibilityBlackQueen(int position, int* moves) {
-
-    int count = 0;
-
-    // Like Bishop :
-
-    // Move up right (+9)
-    for (int i = 9; (((position + i) & 7) != 0) && (position + i) < 64; i+= 9) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move up left (+7)
-    for (int i = 7; (((position + i) & 7) != 7) && (position + i) < 64; i+= 7) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down right (-7)
-    for (int i = -7; (((position + i) & 7) != 0) && (position + i) >= 0; i-= 7) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down left (-9)
-    for (int i = -9; (((position + i) & 7) != 7) && (position + i) >= 0; i-= 9) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // like Tower :
-    // Move right (+1)
-    for (int i = 1; ((position + i) & 7) != 0 && (position + i) < 64; i++) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move left (-1)
-    for (int i = -1; ((position + i) & 7) != 7  && (position + i) >= 0; i--) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move up (+8)
-    for (int i = 8; (position + i) < 64; i += 8) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    // Move down (-8)
-    for (int i = -8; (position + i) >= 0; i -= 8) {
-        if (isThereABlackPieceAt(position + i))
-            break;
-
-        moves[count++] = position + i;
-        if (isThereAWhitePieceAt(position + i)) { 
-            break;
-        }
-    }
-
-    return count;
-}
-
-
-int ChessBoard::possibilityWhiteKing(int position, int* moves) {
-
-    int count = 0;
-
-    // Move up right (+9)
-    if (((position & 7) != 7) && (position + 9) < 64 && !isThereAWhitePieceAt(position + 9)) 
-        moves[count++] = position + 9;
-
-
-    // Move up left (+7)
-    if ((position & 7) != 0 && (position + 7) < 64 &&  !isThereAWhitePieceAt(position + 7)) 
-        moves[count++] = position + 7;
-
-    // Move down right (-7)
-    if ((position & 7) != 7 && (position - 7) >= 0 &&  !isThereAWhitePieceAt(position - 7)) 
-        moves[count++] = position - 7;
-
-    // Move down left (-9)
-    if ((position & 7) != 0 && (position - 9) >= 0 &&  !isThereAWhitePieceAt(position - 9)) 
-        moves[count++] = position - 9;
-
-    // Move right (+1)
-    if (((position & 7) != 7) && (position + 1) < 64 && !isThereAWhitePieceAt(position + 1)) 
-        moves[count++] = position + 1;
-    
+    if (((position & 7) != 7) && (position + 1) < 64 && !isThereAWhitePieceAt(position + 1)) 
+        moves[count++] = position + 1;
+    
     // Move left (-1)
     if (((position & 7) != 0) && (position - 1) >= 0 && !isThereAWhitePieceAt(position - 1)) 
         moves[count++] = position - 1;
@@ -922,891 +923,626 @@ void ChessBoard::undo(int positionFrom, int positionTo, uint64_t* piece, uint64_
         *pieceCaptured |= (1ULL << positionTo); // add a piece if there is a piece
 }
 
-int ChessBoard::evaluate() {
-    int score = 0;
-
-    score += __builtin_popcountll(piece.bitboards[WHITE_PAWN]);
-    score += __builtin_popcountll(piece.bitboards[WHITE_BISHOP]) * 3;
-    score += __builtin_popcountll(piece.bitboards[WHITE_KNIGHT]) * 3;
-    score += __builtin_popcountll(piece.bitboards[WHITE_ROOK]) * 5;
-    score += __builtin_popcountll(piece.bitboards[WHITE_QUEEN]) * 9;
-    score += __builtin_popcountll(piece.bitboards[WHITE_KING]) * 20;
-
-    score -= __builtin_popcountll(piece.bitboards[BLACK_PAWN]);
-    score -= __builtin_popcountll(piece.bitboards[BLACK_BISHOP]) * 3;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_KNIGHT]) * 3;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_ROOK]) * 5;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_QUEEN]) * 9;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_KING]) * 20;
-
-    return score;
-}
-
-int ChessBoard::evaluatePawnPower() {
-    int score = 0;
-    int coef = 1;
-
-
-    uint64_t pawnWhiteBitboard = piece.bitboards[WHITE_PAWN];
-
-    while (pawnWhiteBitboard) {
-        int position = __builtin_ctzll(pawnWhiteBitboard);
-
-        score += (position >> 3);  // = /8    
-        // pawn = 3, then 4 when he move then 5 ...
-   
-        pawnWhiteBitboard &= pawnWhiteBitboard - 1;
-    }
-    
-    score += __builtin_popcountll(piece.bitboards[WHITE_BISHOP]) * 3 * coef;
-    score += __builtin_popcountll(piece.bitboards[WHITE_KNIGHT]) * 3 * coef;
-    score += __builtin_popcountll(piece.bitboards[WHITE_ROOK]) * 5 * coef;
-    score += __builtin_popcountll(piece.bitboards[WHITE_QUEEN]) * 9 * coef;
-    score += __builtin_popcountll(piece.bitboards[WHITE_KING]) * 20 * coef;
-
-    score -= __builtin_popcountll(piece.bitboards[BLACK_BISHOP]) * 3 * coef;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_KNIGHT]) * 3 * coef;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_ROOK]) * 5 * coef;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_QUEEN]) * 9 * coef;
-    score -= __builtin_popcountll(piece.bitboards[BLACK_KING]) * 20 * coef;
-
-    uint64_t pawnBlackBitboard = piece.bitboards[BLACK_PAWN];
-
-    while (pawnBlackBitboard) {
-        int position = __builtin_ctzll(pawnBlackBitboard);
-
-        score -= 7 - (position >> 3);      
-
-        pawnBlackBitboard &= pawnBlackBitboard - 1;
-    }
-
-    return score;
-}
-
-
-int ChessBoard::mouseToPosition(int x, int y, sf::Vector2u& size) {
-    float square_x = static_cast<float>(size.x) / 8.f;
-    float square_y = static_cast<float>(size.y) / 8.f;
-
-    int y_ = 7 - (static_cast<int>(y / square_y) );
-
-    int position =  y_ * 8 +  static_cast<int>(x / square_x);
-
-    return position;
- }
-
- void ChessBoard::movePiece(uint64_t* pieceFrom, uint64_t* pieceTo, int from, int to) {
-    *pieceFrom &= ~(1ULL << from); // delete the piece
-    *pieceFrom |= (1ULL << to); // add the new position of the piece
-    *pieceTo &= ~(1ULL << to); // delete a piece if there is a piece
- }
-
- void ChessBoard::unMovePiece(uint64_t* pieceFrom, uint64_t* pieceTo, int from, int to) {
-    *pieceFrom |= (1ULL << from); // get back the old piece
-    *pieceFrom &= ~(1ULL << to); // delete the new position of the piece
-    *pieceTo |= (1ULL << to); // add a piece if there is a piece
- }
-
- Move ChessBoard::getMoveForAPosition(int position, int to, PieceType pieceType, bool white) {
-    Move move;
-    move.from = position;
-    move.to =  to;
-    move.piece = pieceType;
-    move.moveType = NORMAL_MOVE;        
-    move.castlingType = KINGSIDE;  
-
-    if (pieceType == WHITE_PAWN && to == enPassant) {
-        move.moveType = EN_PASSANT;
-        move.capturedType = BLACK_PAWN;
-    } 
-    else if (pieceType == BLACK_PAWN && to == enPassant) {
-        move.moveType = EN_PASSANT;
-        move.capturedType = WHITE_PAWN;
-    }
-    else {
-        move.moveType = NORMAL_MOVE;
-        if (white)
-            move.capturedType = getPieceTypeIfThereIsABlackPieceAt(to);
-        else
-            move.capturedType = getPieceTypeIfThereIsAWhitePieceAt(to);
-    }
-    return move;
- }
-
-
-bool ChessBoard::isInCheck(bool isWhite) { 
-    
-    // Find position of the King 
-    int position = __builtin_ctzll(piece.bitboards[isWhite? WHITE_KING : BLACK_KING]); 
-    uint64_t mask = 1ULL << position; 
-    
-    // Tower 
-    
-    // Move right (+1) 
-    for (int i = 1; ((position + i) & 7) != 0 && (position + i) < 64; i++) { 
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move left (-1)
-    for (int i = -1; ((position + i) & 7) != 7 && (position + i) >= 0; i--) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move up (+8)
-    for (int i = 8; (position + i) < 64; i += 8) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move down (-8)
-    for (int i = -8; (position + i) >= 0; i -= 8) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
+int ChessBoard::evaluate(EvalTrace* trace) {
+    // Same score as evaluatePawnPower, computed from scratch
+    EvalState state = computeEvalState();
+    MaterialEntry material = computeMaterial(state.materialKey, trace);
+    if (material.evaluation) {
+        if (trace)
+            trace->specialised = true;
+        return material.evaluation(piece.bitboards, material.strongSide);
     }
 
+    PawnEntry pawns = evaluatePawnStructure(piece.bitboards[WHITE_PAWN], piece.bitboards[BLACK_PAWN], trace);
 
-    // Bishop
+    AttackMaps maps;
+    computeAttackMaps(piece.bitboards, maps);
+    int attacksMg, attacksEg;
+    evaluateAttacks(piece.bitboards, maps, attacksMg, attacksEg, trace);
 
-    // Move up right (+9)
-    for (int i = 9; ((position + i) & 7) != 0 && (position + i) < 64; i+= 9) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move up left (+7)
-    for (int i = 7; (((position + i) & 7) != 7) && (position + i) < 64; i+= 7) {
-       if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move down right (-7)
-    for (int i = -7; (((position + i) & 7) != 0) && (position + i) >= 0; i-= 7) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
+    // Material and piece-square tables, in the layout of Evaluation.h
+    if (trace) {
+        for (int pieceType = 0; pieceType < 12; ++pieceType) {
+            int type = pieceType % 6;
+            int sign = pieceType < 6 ? 1 : -1;
+            uint64_t bitboard = piece.bitboards[pieceType];
+            while (bitboard) {
+                int square = __builtin_ctzll(bitboard);
+                trace->add(PARAM_MATERIAL + type, sign);
+                trace->add(PARAM_PST + type * 64 + (pieceType < 6 ? square ^ 56 : square), sign);
+                bitboard &= bitboard - 1;
+            }
         }
     }
 
-    // Move down left (-9)
-    for (int i = -9; (((position + i) & 7) != 7) && (position + i) >= 0; i-= 9) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
+    int mg = state.mg + pawns.mg + attacksMg + material.imbalanceMg;
+    int eg = state.eg + pawns.eg + attacksEg + material.imbalanceEg;
+    int scale = material.scaleFactor(piece.bitboards, eg);
+    if (trace)
+        trace->scale = scale;
+    return material.taper(mg, eg * scale / SCALE_NORMAL);
+}
 
-    // Knight
+int ChessBoard::evaluatePawnPower() {
+    PROFILE_ZONE(ZONE_EVALUATION);
+    // One probe gives the phase, the imbalance and the known endgames
+    const MaterialEntry& material = materialTable.probe(evalState.materialKey);
+    if (material.evaluation)
+        return material.evaluation(piece.bitboards, material.strongSide);
+
+    if (nnue.isLoaded())
+        return evaluateNNUE();
+
+    // Tapered piece-square evaluation, kept up to date by makeMove / unMakeMove
+    const PawnEntry& pawns = pawnHashTable.probe(pawnHash, piece.bitboards[WHITE_PAWN], piece.bitboards[BLACK_PAWN]);
+
+    // Mobility, king safety and hanging pieces depend on every piece : computed at each evaluation
+    AttackMaps maps;
+    computeAttackMaps(piece.bitboards, maps);
+    int attacksMg, attacksEg;
+    evaluateAttacks(piece.bitboards, maps, attacksMg, attacksEg);
+
+    int mg = evalState.mg + pawns.mg + attacksMg + material.imbalanceMg;
+    int eg = evalState.eg + pawns.eg + attacksEg + material.imbalanceEg;
+    return material.taper(mg, eg * material.scaleFactor(piece.bitboards, eg) / SCALE_NORMAL);
+}
 
-    // 2 Up 1 Right (+17)
-    if (((position + 17) < 64) && (position & 7) != 7) {
-        if (isThereAPieceAt(position + 17)) { 
-            mask = 1ULL << (position + 17); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-    
-        }
-    }
 
-    // 2 Down 1 Right (-15)
-    if (((position - 15) >= 0) && (position & 7) != 7) {
-        if (isThereAPieceAt(position - 15)) { 
-            mask = 1ULL << (position - 15); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT]) 
-                return true; 
-     
-        }
-    }
+// Lossy : an entry is overwritten by the last position with the same index
+int ChessBoard::evaluateCached() {
+    EvalCacheEntry& entry = evalCache[currentHash & (EVAL_CACHE_SIZE - 1)];
+    uint32_t key = static_cast<uint32_t>(currentHash >> 32) | 1; // Never 0, the key of an empty entry
 
-    // 2 Right 1 Up (+10)
-    if (((position + 10) < 64) && (position & 7) < 6) {
-        if (isThereAPieceAt(position + 10)) { 
-            mask = 1ULL << (position + 10); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-       
-        }
+    stats.evalProbes++;
+    if (entry.key == key) {
+        stats.evalHits++;
+        return entry.score;
     }
 
-    // 2 Right 1 Down (-6)
-    if (((position - 6) >= 0) && (position & 7) < 6) {
-        if (isThereAPieceAt(position - 6)) { 
-            mask = 1ULL << (position - 6); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-    
-        }
-    }
+    if (entry.key != 0)
+        stats.evalCollisions++;
+    entry.key = key;
+    entry.score = evaluatePawnPower();
+    return entry.score;
+}
 
+// Same start for every search, so that two searches of one position visit the same nodes
+void ChessBoard::clearSearchTables() {
+    transpositionTable.clear();
+    evalCache.assign(EVAL_CACHE_SIZE, EvalCacheEntry());
+    pawnHashTable.clear();
+    materialTable.clear();
+}
 
-    // 2 Left 1 Down (-10)
-    if (((position - 10) >= 0) && (position & 7) > 1) {
-        if (isThereAPieceAt(position - 10)) { 
-            mask = 1ULL << (position - 10); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-       
-        }
-    }
+bool ChessBoard::loadNetwork(const std::string& path) {
+    if (!nnue.load(path))
+        return false;
 
-    // 2 Left 1 Up (+6)
-    if (((position + 6) < 64) && (position & 7) > 1) {
-        if (isThereAPieceAt(position + 6)) { 
-            mask = 1ULL << (position + 6); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT]) 
-                return true; 
-       
-        }
-    }
+    // Scores of the classical evaluation are no longer valid
+    evalCache.assign(EVAL_CACHE_SIZE, EvalCacheEntry());
+    accumulators.assign(1024, Accumulator());
+    accumulatorPly = 0;
+    nnue.refresh(accumulators[0], piece.bitboards, 0);
+    nnue.refresh(accumulators[0], piece.bitboards, 1);
+    return true;
+}
 
+bool ChessBoard::loadBook(const std::string& bookPath) {
+    return book.open(bookPath);
+}
 
-    // 2 Up 1 Left (+15)
-    if (((position + 15) < 64) && (position & 7) != 0) {
-        if (isThereAPieceAt(position + 15)) { 
-            mask = 1ULL << (position + 15); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-        
-        }
-    }
+// A move of the book among the legal moves : Polyglot writes castling as the king taking its rook
+bool ChessBoard::probeBook(bool isWhite, std::vector<Move>& moves, Move& bookMove) {
+    uint16_t polyglotMove;
+    if (!book.isOpen() || !book.probe(computePolyglotKey(isWhite), polyglotMove))
+        return false;
 
+    int to = polyglotMove & 63;
+    int from = (polyglotMove >> 6) & 63;
+    int promotion = (polyglotMove >> 12) & 7; // 1 = knight ... 4 = queen, as PieceType on the side of the pawn
 
-    // 2 Down 1 Left (-17)
-    if (((position - 17) >= 0) && (position & 7) != 0) {
-        if (isThereAPieceAt(position - 17)) { 
-            mask = 1ULL << (position - 17); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-            
-        }
-    }
+    bool kingMove = piece.bitboards[isWhite ? WHITE_KING : BLACK_KING] & (1ULL << from);
+    if (kingMove && (from == 4 || from == 60) && (to == from + 3 || to == from - 4))
+        to = to > from ? from + 2 : from - 2;
 
+    PieceType promotionType = promotion == 0 ? NONE : static_cast<PieceType>((isWhite ? 0 : 6) + promotion);
 
-    //  Pawn
-    if (isWhite) {
+    for (Move& move : moves) {
+        if (move.from != from || move.to != to || move.promotion != promotionType)
+            continue;
 
-        // left part of the board
-        if (((position & 7) != 0) && isThereABlackPieceAt(position + 7)) {
-            mask = 1ULL << (position + 7); 
-            if (mask & piece.bitboards[BLACK_PAWN]) 
-                return true; 
-        }
+        makeMove(move);
+        bool legal = !isInCheck(isWhite);
+        unMakeMove(move);
 
-        // right part of the board
-        if (((position & 7) != 7) && isThereABlackPieceAt(position + 9)) {
-            mask = 1ULL << (position + 9); 
-            if (mask & piece.bitboards[BLACK_PAWN]) 
-                return true; 
+        if (legal) {
+            bookMove = move;
+            return true;
         }
-    } else {
-        // right part of the board
-        if (((position & 7) != 7) && isThereAWhitePieceAt(position - 7)) {
-                mask = 1ULL << (position - 7); 
-                if (mask & piece.bitboards[WHITE_PAWN]) 
-                    return true; 
-            }
-
-        // left part of the board
-        if (((position & 7) != 0) && isThereAWhitePieceAt(position - 9)) {
-                mask = 1ULL << (position - 9); 
-                if (mask & piece.bitboards[WHITE_PAWN]) 
-                    return true; 
-            }
-
     }
-
-    // King 
-
-    // Move up right (+9)
-    if (((position & 7) != 7) && (position + 9) < 64 ) {
-        mask = 1ULL << (position + 9); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-
-    // Move up left (+7)
-    if ((position & 7) != 0 && (position + 7) < 64)  {
-        mask = 1ULL << (position + 7); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-    // Move down right (-7)
-    if ((position & 7) != 7 && (position - 7) >= 0)  {
-        mask = 1ULL << (position - 7); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-    // Move down left (-9)
-    if ((position & 7) != 0 && (position - 9) >= 0)  {
-        mask = 1ULL << (position - 9); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-    // Move right (+1)
-    if (((position & 7) != 7) && (position + 1) < 64)  {
-        mask = 1ULL << (position + 1); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-    
-    // Move left (-1)
-    if (((position & 7) != 0) && (position - 1) >= 0)  {
-        mask = 1ULL << (position - 1); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-    
-    // Move up (+8)
-    if ((position + 8) < 64)  {
-        mask = 1ULL << (position + 8); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-    
-    // Move down (-8)
-    if ((position - 8) >= 0)  {
-        mask = 1ULL << (position - 8); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-
     return false;
 }
 
+bool ChessBoard::loadBitbases(const std::string& directory) {
+    return bitbases.load(directory);
+}
 
+// King and 1 or 2 pieces against a lone king : 0 for a draw, a win otherwise.
+// With the distances to mate the win is a mate score like the ones of the search (exact = true).
+// Without them it is a known win that still grows when the weak king goes to the edge (the right corner
+// in KBNK), the kings get closer and the pawn goes forward, so that the search makes progress.
+bool ChessBoard::probeBitbase(bool isWhite, int depth, int& score, bool& exact) {
+    const uint64_t* bitboards = piece.bitboards;
+    uint64_t key = evalState.materialKey;
+    uint64_t white = key & (NON_PAWN_KEY_MASK[0] | 15 * MATERIAL_KEY_UNIT[WHITE_PAWN]);
+    uint64_t black = key & (NON_PAWN_KEY_MASK[1] | 15 * MATERIAL_KEY_UNIT[BLACK_PAWN]);
+    if ((white && black) || (!white && !black))
+        return false;
 
-bool ChessBoard::isAttacked(int position, bool isWhite) { 
-    
-    uint64_t mask = 1ULL << position; 
-    
-    // Tower 
-    
-    // Move right (+1) 
-    for (int i = 1; ((position + i) & 7) != 0 && (position + i) < 64; i++) { 
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move left (-1)
-    for (int i = -1; ((position + i) & 7) != 7 && (position + i) >= 0; i--) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move up (+8)
-    for (int i = 8; (position + i) < 64; i += 8) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move down (-8)
-    for (int i = -8; (position + i) >= 0; i -= 8) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_ROOK : WHITE_ROOK]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-
-    // Bishop
-
-    // Move up right (+9)
-    for (int i = 9; ((position + i) & 7) != 0 && (position + i) < 64; i+= 9) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move up left (+7)
-    for (int i = 7; (((position + i) & 7) != 7) && (position + i) < 64; i+= 7) {
-       if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
-
-    // Move down right (-7)
-    for (int i = -7; (((position + i) & 7) != 0) && (position + i) >= 0; i-= 7) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
-    }
+    bool strongWhite = white != 0;
+    int offset = strongWhite ? 0 : 6;
+    int count[5];
+    for (int type = 0; type < 5; ++type)
+        count[type] = materialCount(key, offset + type);
+
+    int table;
+    if (count[0] == 1 && count[1] + count[2] + count[3] + count[4] == 0)
+        table = KPK;
+    else if (count[3] == 1 && count[0] + count[1] + count[2] + count[4] == 0)
+        table = KRK;
+    else if (count[4] == 1 && count[0] + count[1] + count[2] + count[3] == 0)
+        table = KQK;
+    else if (count[1] == 1 && count[2] == 1 && count[0] + count[3] + count[4] == 0)
+        table = KBNK;
+    else
+        return false;
 
-    // Move down left (-9)
-    for (int i = -9; (((position + i) & 7) != 7) && (position + i) >= 0; i-= 9) {
-        if (isThereAPieceAt(position + i)) { 
-            mask = 1ULL << (position + i); 
-            if ((mask & piece.bitboards[isWhite? BLACK_BISHOP : WHITE_BISHOP]) || (mask & piece.bitboards[isWhite? BLACK_QUEEN : WHITE_QUEEN]))
-                return true; 
-            break; 
-        }
+    if (!bitbases.isLoaded(table))
+        return false;
+    stats.bitbaseProbes++;
+
+    // Black as the strong side : the board is mirrored
+    int flip = strongWhite ? 0 : 56;
+    int strongKing = __builtin_ctzll(bitboards[offset + 5]) ^ flip;
+    int weakKing = __builtin_ctzll(bitboards[(6 - offset) + 5]) ^ flip;
+    int squares[2];
+    const BitbaseInfo& info = BITBASE_INFO[table];
+    for (int i = 0; i < info.pieceCount; ++i)
+        squares[i] = __builtin_ctzll(bitboards[offset + info.pieces[i]]) ^ flip;
+
+    uint32_t index = bitbaseIndex(isWhite == strongWhite, strongKing, weakKing, squares, info.pieceCount);
+    exact = bitbases.hasDistances(table);
+
+    if (!bitbases.probe(table, index)) {
+        score = 0;
+        return true;
+    }
+
+    // Mated in distance plies, at depth - distance : same score as the mate found by the search
+    if (exact) {
+        int distance = bitbases.distanceToMate(table, index);
+        score = strongWhite ? MATE_SCORE + depth - distance : -MATE_SCORE - depth + distance;
+        return true;
+    }
+
+    int weakFile = weakKing & 7, weakRank = weakKing >> 3;
+    int kingsDistance = std::max(std::abs(weakFile - (strongKing & 7)), std::abs(weakRank - (strongKing >> 3)));
+    int progress = 10 * (7 - kingsDistance);
+
+    if (table == KBNK) {
+        // Only the corners of the color of the bishop can be mated
+        bool darkBishop = (((squares[0] >> 3) + (squares[0] & 7)) & 1) == 0;
+        int corners[2] = {darkBishop ? 0 : 7, darkBishop ? 63 : 56};
+        int cornerDistance = 7;
+        for (int corner : corners)
+            cornerDistance = std::min(cornerDistance, std::max(std::abs(weakFile - (corner & 7)), std::abs(weakRank - (corner >> 3))));
+        progress += 20 * (7 - cornerDistance);
+    } else {
+        int edgeDistance = std::min(std::min(weakFile, 7 - weakFile), std::min(weakRank, 7 - weakRank));
+        progress += 20 * (3 - edgeDistance);
     }
 
-    // Knight
+    // The pieces count too : a promotion is always better
+    for (int i = 0; i < info.pieceCount; ++i)
+        progress += PIECE_VALUE[info.pieces[i]];
+    if (table == KPK)
+        progress += 20 * (squares[0] >> 3);
 
-    // 2 Up 1 Right (+17)
-    if (((position + 17) < 64) && (position & 7) != 7) {
-        if (isThereAPieceAt(position + 17)) { 
-            mask = 1ULL << (position + 17); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-    
-        }
-    }
+    score = strongWhite ? BITBASE_WIN + progress : -(BITBASE_WIN + progress);
+    return true;
+}
 
-    // 2 Down 1 Right (-15)
-    if (((position - 15) >= 0) && (position & 7) != 7) {
-        if (isThereAPieceAt(position - 15)) { 
-            mask = 1ULL << (position - 15); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT]) 
-                return true; 
-     
-        }
-    }
+// Called by makeMove (and makeNullMove with nullptr) : the accumulator is only computed when evaluated
+void ChessBoard::pushAccumulator(const Move* move) {
+    if (accumulatorPly + 1 == static_cast<int>(accumulators.size()))
+        accumulators.resize(accumulators.size() * 2);
 
-    // 2 Right 1 Up (+10)
-    if (((position + 10) < 64) && (position & 7) < 6) {
-        if (isThereAPieceAt(position + 10)) { 
-            mask = 1ULL << (position + 10); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-       
-        }
-    }
-
-    // 2 Right 1 Down (-6)
-    if (((position - 6) >= 0) && (position & 7) < 6) {
-        if (isThereAPieceAt(position - 6)) { 
-            mask = 1ULL << (position - 6); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-    
-        }
-    }
+    Accumulator& accumulator = accumulators[++accumulatorPly];
+    accumulator.computed[0] = false;
+    accumulator.computed[1] = false;
+    accumulator.dirtyCount = 0;
 
+    if (move == nullptr)
+        return;
 
-    // 2 Left 1 Down (-10)
-    if (((position - 10) >= 0) && (position & 7) > 1) {
-        if (isThereAPieceAt(position - 10)) { 
-            mask = 1ULL << (position - 10); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-       
-        }
+    if (move->capturedType != NONE) {
+        int capturedSquare = move->to;
+        if (move->moveType == EN_PASSANT)
+            capturedSquare = move->piece == WHITE_PAWN ? (move->to - 8) : (move->to + 8);
+        accumulator.dirty[accumulator.dirtyCount++] = {move->capturedType, capturedSquare, -1};
     }
 
-    // 2 Left 1 Up (+6)
-    if (((position + 6) < 64) && (position & 7) > 1) {
-        if (isThereAPieceAt(position + 6)) { 
-            mask = 1ULL << (position + 6); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT]) 
-                return true; 
-       
-        }
+    if (move->moveType == PROMOTION) {
+        accumulator.dirty[accumulator.dirtyCount++] = {move->piece, move->from, -1};
+        accumulator.dirty[accumulator.dirtyCount++] = {move->promotion, -1, move->to};
+    } else {
+        accumulator.dirty[accumulator.dirtyCount++] = {move->piece, move->from, move->to};
     }
 
-
-    // 2 Up 1 Left (+15)
-    if (((position + 15) < 64) && (position & 7) != 0) {
-        if (isThereAPieceAt(position + 15)) { 
-            mask = 1ULL << (position + 15); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-        
-        }
+    if (move->moveType == CASTLING) {
+        int index = castlingIndex(*move);
+        accumulator.dirty[accumulator.dirtyCount++] = {move->piece == WHITE_KING ? WHITE_ROOK : BLACK_ROOK,
+                                                       CASTLING_ROOK_FROM[index], CASTLING_ROOK_TO[index]};
     }
+}
 
+int ChessBoard::evaluateNNUE() {
+    Accumulator& accumulator = accumulators[accumulatorPly];
 
-    // 2 Down 1 Left (-17)
-    if (((position - 17) >= 0) && (position & 7) != 0) {
-        if (isThereAPieceAt(position - 17)) { 
-            mask = 1ULL << (position - 17); 
-            if (mask & piece.bitboards[isWhite? BLACK_KNIGHT : WHITE_KNIGHT])
-                return true; 
-            
-        }
-    }
-
-    //  Pawn
-    if (isWhite) {
+    for (int perspective = 0; perspective < 2; ++perspective) {
+        if (accumulator.computed[perspective])
+            continue;
 
-        // left part of the board
-        if (((position & 7) != 0) && isThereABlackPieceAt(position + 7)) {
-            mask = 1ULL << (position + 7); 
-            if (mask & piece.bitboards[BLACK_PAWN]) 
-                return true; 
-        }
+        // Go back to the last computed accumulator, unless the king of this side moved since
+        int king = perspective == 0 ? WHITE_KING : BLACK_KING;
+        int ply = accumulatorPly;
+        bool refresh = false;
 
-        // right part of the board
-        if (((position & 7) != 7) && isThereABlackPieceAt(position + 9)) {
-            mask = 1ULL << (position + 9); 
-            if (mask & piece.bitboards[BLACK_PAWN]) 
-                return true; 
-        }
-    } else {
-        // right part of the board
-        if (((position & 7) != 7) && isThereAWhitePieceAt(position - 7)) {
-                mask = 1ULL << (position - 7); 
-                if (mask & piece.bitboards[WHITE_PAWN]) 
-                    return true; 
-            }
+        while (!accumulators[ply].computed[perspective]) {
+            const Accumulator& current = accumulators[ply];
+            for (int i = 0; i < current.dirtyCount; ++i)
+                if (current.dirty[i].piece == king)
+                    refresh = true;
 
-        // left part of the board
-        if (((position & 7) != 0) && isThereAWhitePieceAt(position - 9)) {
-                mask = 1ULL << (position - 9); 
-                if (mask & piece.bitboards[WHITE_PAWN]) 
-                    return true; 
+            if (refresh || ply == 0) {
+                refresh = true;
+                break;
             }
-
-    }
-
-
-    // King 
-
-    // Move up right (+9)
-    if (((position & 7) != 7) && (position + 9) < 64 ) {
-        mask = 1ULL << (position + 9); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-
-    // Move up left (+7)
-    if ((position & 7) != 0 && (position + 7) < 64)  {
-        mask = 1ULL << (position + 7); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-    // Move down right (-7)
-    if ((position & 7) != 7 && (position - 7) >= 0)  {
-        mask = 1ULL << (position - 7); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-
-    // Move down left (-9)
-    if ((position & 7) != 0 && (position - 9) >= 0)  {
-        mask = 1ULL << (position - 9); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
+            ply--;
         }
 
-    // Move right (+1)
-    if (((position & 7) != 7) && (position + 1) < 64)  {
-        mask = 1ULL << (position + 1); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-    
-    // Move left (-1)
-    if (((position & 7) != 0) && (position - 1) >= 0)  {
-        mask = 1ULL << (position - 1); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-    
-    // Move up (+8)
-    if ((position + 8) < 64)  {
-        mask = 1ULL << (position + 8); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
-        }
-    
-    // Move down (-8)
-    if ((position - 8) >= 0)  {
-        mask = 1ULL << (position - 8); 
-        if (mask & piece.bitboards[isWhite? BLACK_KING : WHITE_KING])
-            return true; 
+        if (refresh) {
+            nnue.refresh(accumulator, piece.bitboards, perspective);
+        } else {
+            for (int p = ply + 1; p <= accumulatorPly; ++p)
+                nnue.update(accumulators[p - 1], accumulators[p], piece.bitboards, perspective);
         }
+    }
 
-
-    return false;
+    return nnue.evaluate(accumulator);
 }
 
 
+int ChessBoard::mouseToPosition(int x, int y, sf::Vector2u& size) {
+    float square_x = static_cast<float>(size.x) / 8.f;
+    float square_y = static_cast<float>(size.y) / 8.f;
 
-void ChessBoard::possibilityCastle(std::vector<Move>& movesList, bool isWhite) {
-    if (isWhite) {
-        if (whiteKingSideCastling) {
-            if (!isThereAPieceAt(5) && !isThereAPieceAt(6)) {
-                if (!isAttacked(5, true) && !isAttacked(6, true) && !isInCheck(true)) {
-                    Move move;
-                    move.piece = WHITE_KING;
-                    move.moveType = CASTLING;
-                    move.castlingType = KINGSIDE;
-                    move.from = 4; // The king go from 4 to 6
-                    move.to = 6;
-                    move.capturedType = NONE;
-                    movesList.push_back(move);
-                }
-            }
-        }
-
-        if (whiteQueenSideCastling) {
-            if (!isThereAPieceAt(1) && !isThereAPieceAt(2) && !isThereAPieceAt(3)) {
-                if (!isAttacked(1, true) && !isAttacked(2, true) && !isAttacked(3, true) && !isInCheck(true)) {
-                    Move move;
-                    move.piece = WHITE_KING;
-                    move.moveType = CASTLING;
-                    move.castlingType = QUEENSIDE;
-                    move.from = 4; // The king go from 4 to 2
-                    move.to = 2;
-                    move.capturedType = NONE;
-                    movesList.push_back(move);
-                }
-            }
-        }
+    int y_ = 7 - (static_cast<int>(y / square_y) );
 
+    int position =  y_ * 8 +  static_cast<int>(x / square_x);
 
-    } else {
+    return position;
+ }
 
-        if (blackKingSideCastling) {
-            if (!isThereAPieceAt(61) && !isThereAPieceAt(62)) {
-                if (!isAttacked(61, false) && !isAttacked(62, false) && !isInCheck(false)) {
-                    Move move;
-                    move.piece = BLACK_KING;
-                    move.moveType = CASTLING;
-                    move.castlingType = KINGSIDE;
-                    move.from = 60; // The king go from 60 to 62
-                    move.to = 62;
-                    move.capturedType = NONE;
-                    movesList.push_back(move);
-                }
-            }
-        }
+ void ChessBoard::movePiece(uint64_t* pieceFrom, uint64_t* pieceTo, int from, int to) {
+    *pieceFrom &= ~(1ULL << from); // delete the piece
+    *pieceFrom |= (1ULL << to); // add the new position of the piece
+    *pieceTo &= ~(1ULL << to); // delete a piece if there is a piece
+ }
 
-        if (blackQueenSideCastling) {
-            if (!isThereAPieceAt(57) && !isThereAPieceAt(58) && !isThereAPieceAt(59)) {
-                if (!isAttacked(57, false) && !isAttacked(58, false) && !isAttacked(59, false) && !isInCheck(false)) {
-                    Move move;
-                    move.piece = BLACK_KING;
-                    move.moveType = CASTLING;
-                    move.castlingType = QUEENSIDE;
-                    move.from = 60; // The king go from 60 to 58
-                    move.to = 58;
-                    move.capturedType = NONE;
-                    movesList.push_back(move);
-                }
-            }
-        }
+ void ChessBoard::unMovePiece(uint64_t* pieceFrom, uint64_t* pieceTo, int from, int to) {
+    *pieceFrom |= (1ULL << from); // get back the old piece
+    *pieceFrom &= ~(1ULL << to); // delete the new position of the piece
+    *pieceTo |= (1ULL << to); // add a piece if there is a piece
+ }
 
+ Move ChessBoard::getMoveForAPosition(int position, int to, PieceType pieceType, bool white) {
+    Move move;
+    move.from = position;
+    move.to =  to;
+    move.piece = pieceType;
+    move.moveType = NORMAL_MOVE;        
+    move.castlingType = KINGSIDE;  
 
+    if (pieceType == WHITE_PAWN && to == enPassant) {
+        move.moveType = EN_PASSANT;
+        move.capturedType = BLACK_PAWN;
+    } 
+    else if (pieceType == BLACK_PAWN && to == enPassant) {
+        move.moveType = EN_PASSANT;
+        move.capturedType = WHITE_PAWN;
     }
-
-}
-
-std::vector<Move> ChessBoard::allMovesForWhite() {
-    std::vector<Move> movesList;
-
-    // WHITE_KNIGHT
-    std::vector<int> positions = getPositionsPiece(piece.bitboards[WHITE_KNIGHT]);
-
-    for (int position : positions) {
-        int moves[8];
-        int counts = possibilityWhiteKnight(position, moves);
-
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], WHITE_KNIGHT, true));
+    else {
+        move.moveType = NORMAL_MOVE;
+        if (white)
+            move.capturedType = getPieceTypeIfThereIsABlackPieceAt(to);
+        else
+            move.capturedType = getPieceTypeIfThereIsAWhitePieceAt(to);
     }
+    return move;
+ }
 
-    // WHITE_BISHOP
-    positions = getPositionsPiece(piece.bitboards[WHITE_BISHOP]);
 
-    for (int position : positions) {
-        int moves[14];
-        int counts = possibilityWhiteBishop(position, moves);
+// A pawn reaching the last rank gives one move per piece, the queen first : the GUI plays the first one
+void ChessBoard::addPawnMove(std::vector<Move>& movesList, int from, int to, bool white) {
+    Move move = getMoveForAPosition(from, to, white ? WHITE_PAWN : BLACK_PAWN, white);
+    if ((to >> 3) != (white ? 7 : 0)) {
+        movesList.push_back(move);
+        return;
+    }
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], WHITE_BISHOP, true));
+    move.moveType = PROMOTION;
+    for (int type = WHITE_QUEEN; type >= WHITE_KNIGHT; --type) {
+        move.promotion = static_cast<PieceType>((white ? 0 : 6) + type);
+        movesList.push_back(move);
     }
+}
+
+// The king attacked by a piece of the other side : one of the kernels built per CpuLevel
+bool ChessBoard::isInCheck(bool isWhite) {
+    PROFILE_ZONE(ZONE_IS_IN_CHECK);
+    int king = __builtin_ctzll(piece.bitboards[isWhite ? WHITE_KING : BLACK_KING]);
+    return isSquareAttacked(piece.bitboards, king, isWhite ? 1 : 0);
+}
 
-    // WHITE_ROOK
-    positions = getPositionsPiece(piece.bitboards[WHITE_ROOK]);
 
-    for (int position : positions) {
-        int moves[16];
-        int counts = possibilityWhiteTower(position, moves);
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], WHITE_ROOK, true));
-    }
+// Attacked by a piece of the other side : the kernel of isInCheck (Attacks.cpp)
+bool ChessBoard::isAttacked(int position, bool isWhite) {
+    return isSquareAttacked(piece.bitboards, position, isWhite ? 1 : 0);
+}
 
-    // WHITE_QUEEN
-    positions = getPositionsPiece(piece.bitboards[WHITE_QUEEN]);
 
-    for (int position : positions) {
-        int moves[27];
-        int counts = possibilityWhiteQueen(position, moves);
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], WHITE_QUEEN, true));
-    }
+void ChessBoard::possibilityCastle(std::vector<Move>& movesList, bool isWhite) {
+    bool kingSide = castlingRights & (isWhite ? WHITE_KING_SIDE_RIGHT : BLACK_KING_SIDE_RIGHT);
+    bool queenSide = castlingRights & (isWhite ? WHITE_QUEEN_SIDE_RIGHT : BLACK_QUEEN_SIDE_RIGHT);
+    int rank = isWhite ? 0 : 56;
+
+    // Squares between the king and the rook must be empty
+    kingSide = kingSide && !isThereAPieceAt(rank + 5) && !isThereAPieceAt(rank + 6);
+    queenSide = queenSide && !isThereAPieceAt(rank + 1) && !isThereAPieceAt(rank + 2) && !isThereAPieceAt(rank + 3);
+    if (!kingSide && !queenSide)
+        return;
 
-    // WHITE_KING
-    positions = getPositionsPiece(piece.bitboards[WHITE_KING]);
+    // The king can't be in check, go through or arrive on an attacked square (b1 / b8 can be attacked)
+    AttackMaps maps;
+    computeAttackMaps(piece.bitboards, maps);
+    uint64_t attacked = maps.bySide[isWhite ? 1 : 0];
 
-    for (int position : positions) {
-        int moves[27];
-        int counts = possibilityWhiteKing(position, moves);
+    Move move;
+    move.piece = isWhite ? WHITE_KING : BLACK_KING;
+    move.moveType = CASTLING;
+    move.from = rank + 4;
+    move.capturedType = NONE;
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], WHITE_KING, true));
+    if (kingSide && !(attacked & (0x70ULL << rank))) { // e, f, g
+        move.castlingType = KINGSIDE;
+        move.to = rank + 6;
+        movesList.push_back(move);
     }
 
-    // WHITE_PAWN
-    positions = getPositionsPiece(piece.bitboards[WHITE_PAWN]);
+    if (queenSide && !(attacked & (0x1CULL << rank))) { // c, d, e
+        move.castlingType = QUEENSIDE;
+        move.to = rank + 2;
+        movesList.push_back(move);
+    }
+}
 
-    for (int position : positions) {
+// Pseudo-legal moves : knights, bishops, rooks, queens, king then pawns, each piece from a1 to h8
+template <CpuLevel level>
+KERNEL void generateMovesKernel(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    const uint64_t* bitboards = board.piece.bitboards;
+    int us = isWhite ? 0 : 6;
+    uint64_t own = 0, occupied = 0;
+    for (int i = 0; i < 12; ++i)
+        occupied |= bitboards[i];
+    for (int i = 0; i < 6; ++i)
+        own |= bitboards[us + i];
+
+    for (int type = 1; type < 6; ++type) {
+        PieceType pieceType = static_cast<PieceType>(us + type);
+        for (uint64_t pieces = bitboards[us + type]; pieces; pieces &= pieces - 1) {
+            int from = __builtin_ctzll(pieces);
+            uint64_t targets = pieceAttacksFrom<level>(type, from, occupied) & ~own;
+            for (; targets; targets &= targets - 1)
+                movesList.push_back(board.getMoveForAPosition(from, __builtin_ctzll(targets), pieceType, isWhite));
+        }
+    }
+
+    for (uint64_t pawns = bitboards[us]; pawns; pawns &= pawns - 1) {
+        int from = __builtin_ctzll(pawns);
         int moves[4];
-        int counts = possibilityWhitePawn(position, moves);
+        int counts = isWhite ? board.possibilityWhitePawn(from, moves) : board.possibilityBlackPawn(from, moves);
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], WHITE_PAWN, true));
+        for (int i = 0; i < counts; ++i)
+            board.addPawnMove(movesList, from, moves[i], isWhite);
     }
 
-    possibilityCastle(movesList, true);
-
-    return movesList;
- }
-
-
-
- std::vector<Move> ChessBoard::allMovesForBlack() {
-    std::vector<Move> movesList;
-
-    
+    board.possibilityCastle(movesList, isWhite);
+}
 
-    // BLACK_KNIGHT
-    std::vector<int> positions = getPositionsPiece(piece.bitboards[BLACK_KNIGHT]);
+// In check : king moves to squares the opponent doesn't attack and, against a single checker, its capture or a
+// piece put between it and the king. Pinned pieces are still left to the isInCheck test after the move.
+template <CpuLevel level>
+KERNEL void evasionMovesKernel(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    const uint64_t* bitboards = board.piece.bitboards;
+    int us = isWhite ? 0 : 6;
+    int them = 6 - us;
 
-    for (int position : positions) {
-        int moves[8];
-        int counts = possibilityBlackKnight(position, moves);
+    uint64_t own = 0, enemy = 0;
+    for (int i = 0; i < 6; ++i) {
+        own |= bitboards[us + i];
+        enemy |= bitboards[them + i];
+    }
+    uint64_t occupied = own | enemy;
+    uint64_t empty = ~occupied;
+    uint64_t king = bitboards[us + 5];
+    int kingSquare = __builtin_ctzll(king);
+
+    uint64_t diagonal = bitboards[them + 2] | bitboards[them + 4];
+    uint64_t straight = bitboards[them + 3] | bitboards[them + 4];
+    uint64_t kingDiagonal = bishopAttacksOf<level>(king, occupied);
+    uint64_t kingStraight = rookAttacksOf<level>(king, occupied);
+    uint64_t checkers = (knightAttacks(king) & bitboards[them + 1]) |
+                        ((isWhite ? whitePawnAttacks(king) : blackPawnAttacks(king)) & bitboards[them]) |
+                        (kingDiagonal & diagonal) | (kingStraight & straight);
+
+    // The king is taken off the board : it can't step back along the line of a slider
+    uint64_t occupiedWithoutKing = occupied & ~king;
+    uint64_t attacked = (isWhite ? blackPawnAttacks(bitboards[them]) : whitePawnAttacks(bitboards[them])) |
+                        knightAttacks(bitboards[them + 1]) | bishopAttacksOf<level>(diagonal, occupiedWithoutKing) |
+                        rookAttacksOf<level>(straight, occupiedWithoutKing) | kingAttacks(bitboards[them + 5]);
+
+    PieceType kingType = isWhite ? WHITE_KING : BLACK_KING;
+    uint64_t kingTargets = kingAttacks(king) & ~own & ~attacked;
+    while (kingTargets) {
+        movesList.push_back(board.getMoveForAPosition(kingSquare, __builtin_ctzll(kingTargets), kingType, isWhite));
+        kingTargets &= kingTargets - 1;
+    }
+
+    // Double check : only the king can move
+    if (checkers == 0 || (checkers & (checkers - 1)))
+        return;
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], BLACK_KNIGHT, false));
+    // The checker, and for a slider the squares between it and the king
+    uint64_t target = checkers;
+    if (kingDiagonal & checkers & diagonal)
+        target |= kingDiagonal & bishopAttacksOf<level>(checkers, occupied);
+    else if (kingStraight & checkers & straight)
+        target |= kingStraight & rookAttacksOf<level>(checkers, occupied);
+
+    for (int type = 1; type < 5; ++type) {
+        uint64_t pieces = bitboards[us + type];
+        while (pieces) {
+            int from = __builtin_ctzll(pieces);
+            uint64_t targets = pieceAttacksFrom<level>(type, from, occupied) & target;
+            while (targets) {
+                movesList.push_back(board.getMoveForAPosition(from, __builtin_ctzll(targets), static_cast<PieceType>(us + type), isWhite));
+                targets &= targets - 1;
+            }
+            pieces &= pieces - 1;
+        }
     }
 
-    // BLACK_BISHOP
-    positions = getPositionsPiece(piece.bitboards[BLACK_BISHOP]);
+    // Pawns : pushes on the line of the check, captures of the checker, and en passant when the checker
+    // is the pawn that has just moved two squares
+    int forward = isWhite ? 8 : -8;
+    int startRank = isWhite ? 1 : 6;
+    int checkerSquare = __builtin_ctzll(checkers);
+    bool enPassantCheck = board.enPassant != -1 && checkerSquare == board.enPassant - forward;
+    uint64_t pawns = bitboards[us];
+    while (pawns) {
+        int from = __builtin_ctzll(pawns);
+        uint64_t square = 1ULL << from;
+        uint64_t captures = isWhite ? whitePawnAttacks(square) : blackPawnAttacks(square);
+        int push = from + forward;
 
-    for (int position : positions) {
-        int moves[14];
-        int counts = possibilityBlackBishop(position, moves);
+        if (empty & (1ULL << push)) {
+            if (target & (1ULL << push))
+                board.addPawnMove(movesList, from, push, isWhite);
+            if ((from >> 3) == startRank && (target & empty & (1ULL << (push + forward))))
+                board.addPawnMove(movesList, from, push + forward, isWhite);
+        }
+        if (captures & checkers)
+            board.addPawnMove(movesList, from, checkerSquare, isWhite);
+        if (enPassantCheck && (captures & (1ULL << board.enPassant)))
+            board.addPawnMove(movesList, from, board.enPassant, isWhite);
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], BLACK_BISHOP, false));
+        pawns &= pawns - 1;
     }
+}
 
-    // BLACK_ROOK
-    positions = getPositionsPiece(piece.bitboards[BLACK_ROOK]);
 
-    for (int position : positions) {
-        int moves[16];
-        int counts = possibilityBlackTower(position, moves);
+// One version per CpuLevel, chosen at each call by cpuLevel
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], BLACK_ROOK, false));
-    }
+static void generateMovesGeneric(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    generateMovesKernel<CPU_GENERIC>(board, movesList, isWhite);
+}
+
+static void evasionMovesGeneric(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    evasionMovesKernel<CPU_GENERIC>(board, movesList, isWhite);
+}
 
-    // BLACK_QUEEN
-    positions = getPositionsPiece(piece.bitboards[BLACK_QUEEN]);
+#ifdef CPU_X86_64
 
-    for (int position : positions) {
-        int moves[27];
-        int counts = possibilityBlackQueen(position, moves);
+__attribute__((target("popcnt")))
+static void generateMovesPopcnt(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    generateMovesKernel<CPU_POPCNT>(board, movesList, isWhite);
+}
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], BLACK_QUEEN, false));
-    }
+__attribute__((target("popcnt")))
+static void evasionMovesPopcnt(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    evasionMovesKernel<CPU_POPCNT>(board, movesList, isWhite);
+}
 
-    // BLACK_KING
-    positions = getPositionsPiece(piece.bitboards[BLACK_KING]);
+__attribute__((target("popcnt,bmi,bmi2")))
+static void generateMovesBmi2(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    generateMovesKernel<CPU_BMI2>(board, movesList, isWhite);
+}
 
-    for (int position : positions) {
-        int moves[27];
-        int counts = possibilityBlackKing(position, moves);
+__attribute__((target("popcnt,bmi,bmi2")))
+static void evasionMovesBmi2(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+    evasionMovesKernel<CPU_BMI2>(board, movesList, isWhite);
+}
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], BLACK_KING, false));
-    }
+#endif
 
-    // BLACK_PAWN
-    positions = getPositionsPiece(piece.bitboards[BLACK_PAWN]);
+static void generateMoves(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+#ifdef CPU_X86_64
+    if (cpuLevel == CPU_BMI2)
+        return generateMovesBmi2(board, movesList, isWhite);
+    if (cpuLevel == CPU_POPCNT)
+        return generateMovesPopcnt(board, movesList, isWhite);
+#endif
+    generateMovesGeneric(board, movesList, isWhite);
+}
 
-    for (int position : positions) {
-        int moves[4];
-        int counts = possibilityBlackPawn(position, moves);
+static void generateEvasions(ChessBoard& board, std::vector<Move>& movesList, bool isWhite) {
+#ifdef CPU_X86_64
+    if (cpuLevel == CPU_BMI2)
+        return evasionMovesBmi2(board, movesList, isWhite);
+    if (cpuLevel == CPU_POPCNT)
+        return evasionMovesPopcnt(board, movesList, isWhite);
+#endif
+    evasionMovesGeneric(board, movesList, isWhite);
+}
 
-        for (int i = 0; i < counts; ++i) 
-            movesList.push_back(getMoveForAPosition(position, moves[i], BLACK_PAWN, false));
-    }
+std::vector<Move> ChessBoard::allMovesForWhite() {
+    PROFILE_ZONE(ZONE_MOVE_GENERATION);
+    std::vector<Move> movesList;
+    generateMoves(*this, movesList, true);
+    return movesList;
+}
 
-    possibilityCastle(movesList, false);
+std::vector<Move> ChessBoard::allMovesForBlack() {
+    PROFILE_ZONE(ZONE_MOVE_GENERATION);
+    std::vector<Move> movesList;
+    generateMoves(*this, movesList, false);
+    return movesList;
+}
 
+std::vector<Move> ChessBoard::evasionMoves(bool isWhite) {
+    PROFILE_ZONE(ZONE_MOVE_GENERATION);
+    std::vector<Move> movesList;
+    generateEvasions(*this, movesList, isWhite);
     return movesList;
- }
+}
 
  
 
 void ChessBoard::moveOrdering(std::vector<Move>* moves) {
+    PROFILE_ZONE(ZONE_MOVE_ORDERING);
     // Valeurs des pièces
     static const int pieceValues[] = {
         100, 100,   // PAWN
@@ -1824,7 +1560,13 @@ void ChessBoard::moveOrdering(std::vector<Move>* moves) {
             scoreA = pieceValues[a.capturedType] * 10 - pieceValues[a.piece];
         if (b.capturedType != NONE)
             scoreB = pieceValues[b.capturedType] * 10 - pieceValues[b.piece];
-            
+
+        // Promotions by the value of the new piece : the queen before the under-promotions
+        if (a.moveType == PROMOTION)
+            scoreA += PIECE_VALUE[a.promotion];
+        if (b.moveType == PROMOTION)
+            scoreB += PIECE_VALUE[b.promotion];
+
         return scoreA > scoreB;
     });
 }
@@ -1839,378 +1581,724 @@ void ChessBoard::printMove(Move& move) {
     std::cout << "Move.capturedType " << move.capturedType << std::endl;
     std::cout << "Move.moveType " << move.moveType << std::endl;
     std::cout << "Move.castlingType " << move.castlingType << std::endl;
-    std::cout << "Move.whiteKingSideCastlingBefore " << move.whiteKingSideCastlingBefore << std::endl;
-    std::cout << "Move.whiteQueenSideCastlingBefore " << move.whiteQueenSideCastlingBefore << std::endl;
-    std::cout << "Move.blackKingSideCastlingBefore " << move.blackKingSideCastlingBefore << std::endl;
-    std::cout << "Move.blackQueenSideCastlingBefore " << move.blackQueenSideCastlingBefore << std::endl;
+    std::cout << "Move.promotion " << move.promotion << std::endl;
     std::cout << "------------------------------------------------" << std::endl;
     std::cout << "                                                 " << std::endl;
 
 }
 
-bool ChessBoard::makeMove(Move& move) {
+void ChessBoard::makeMove(Move& move) {
+    PROFILE_ZONE(ZONE_MAKE_MOVE);
+
+#ifdef VERIFY_STATE
+    checkState(move.piece < 6, "makeMove");
+    debugSnapshots.push_back(snapshot());
+#endif
+
+    // Everything unMakeMove gives back
+    StateInfo& state = states[statePly++];
+    state.hash = currentHash;
+    state.pawnHash = pawnHash;
+    state.evalState = evalState;
+    state.castling = castlingRights;
+    state.enPassant = enPassant;
+    state.rule50 = rule50;
+    state.pliesFromNull = pliesFromNull;
+    state.captured = move.capturedType;
+
+    bool pawnMove = move.piece == WHITE_PAWN || move.piece == BLACK_PAWN;
+    rule50 = (pawnMove || move.capturedType != NONE) ? 0 : rule50 + 1;
+    pliesFromNull++;
+
+    pawnHash = ZOBRIST.updatePawnHash(pawnHash, move);
+    if (nnue.isLoaded())
+        pushAccumulator(&move);
+
+    // The pawn taken en passant is behind the destination
+    if (move.capturedType != NONE) {
+        int capturedSquare = move.moveType == EN_PASSANT ? move.to ^ 8 : move.to;
+        piece.bitboards[move.capturedType] &= ~(1ULL << capturedSquare);
+        evalState.remove(move.capturedType, capturedSquare);
+    }
 
-    hashHistory.push_back(currentHash);
+    // A promotion puts its piece on the destination instead of the pawn
+    PieceType placed = move.moveType == PROMOTION ? move.promotion : move.piece;
+    piece.bitboards[move.piece] &= ~(1ULL << move.from);
+    piece.bitboards[placed] |= 1ULL << move.to;
+    evalState.remove(move.piece, move.from);
+    evalState.add(placed, move.to);
 
-    // Save before change flags
-    move.whiteKingSideCastlingBefore = whiteKingSideCastling;
-    move.whiteQueenSideCastlingBefore = whiteQueenSideCastling;
-    move.blackKingSideCastlingBefore = blackKingSideCastling;
-    move.blackQueenSideCastlingBefore = blackQueenSideCastling;
+    if (move.moveType == CASTLING) {
+        int index = castlingIndex(move);
+        PieceType rook = move.piece == WHITE_KING ? WHITE_ROOK : BLACK_ROOK;
+        piece.bitboards[rook] ^= (1ULL << CASTLING_ROOK_FROM[index]) | (1ULL << CASTLING_ROOK_TO[index]);
+        evalState.move(rook, CASTLING_ROOK_FROM[index], CASTLING_ROOK_TO[index]);
+    }
 
-    move.whiteKingSideCastlingAfter = whiteKingSideCastling;
-    move.whiteQueenSideCastlingAfter = whiteQueenSideCastling;
-    move.blackKingSideCastlingAfter = blackKingSideCastling;
-    move.blackQueenSideCastlingAfter = blackQueenSideCastling;
+    // Square jumped over by a pawn moving two squares
+    enPassant = pawnMove && (move.from ^ move.to) == 16 ? (move.from + move.to) / 2 : -1;
+    castlingRights &= CASTLING_MASK[move.from] & CASTLING_MASK[move.to];
 
-    move.enPassantSquareBefore = enPassant;
-    enPassant = -1;
+    currentHash = ZOBRIST.updateHash(currentHash, move, state.castling, state.enPassant, enPassant);
+}
 
-    if (move.capturedType != NONE) {
-        piece.bitboards[move.capturedType] &= ~(1ULL << move.to);
+void ChessBoard::unMakeMove(Move& move) {
+    PROFILE_ZONE(ZONE_UNMAKE_MOVE);
+#ifdef VERIFY_STATE
+    checkState(move.piece >= 6, "unMakeMove");
+#endif
+    // Hashes, evaluation state and flags come back from the stack, only the pieces are moved back
+    const StateInfo& state = states[--statePly];
+    currentHash = state.hash;
+    pawnHash = state.pawnHash;
+    evalState = state.evalState;
+    castlingRights = state.castling;
+    enPassant = state.enPassant;
+    rule50 = state.rule50;
+    pliesFromNull = state.pliesFromNull;
+    if (nnue.isLoaded())
+        accumulatorPly--;
+
+    PieceType placed = move.moveType == PROMOTION ? move.promotion : move.piece;
+    piece.bitboards[placed] &= ~(1ULL << move.to);
+    piece.bitboards[move.piece] |= 1ULL << move.from;
 
-        if (move.capturedType == WHITE_ROOK && move.to == 7) {
-            whiteKingSideCastling = false;
-            move.whiteKingSideCastlingAfter = false;
-            }
-        if (move.capturedType == WHITE_ROOK && move.to == 0) {
-            whiteQueenSideCastling = false;
-            move.whiteQueenSideCastlingAfter = false;
-            }
-        if (move.capturedType == BLACK_ROOK && move.to == 56) {
-            blackQueenSideCastling = false;
-            move.blackKingSideCastlingAfter = false;
-            }
-        if (move.capturedType == BLACK_ROOK && move.to == 63) {
-            blackKingSideCastling = false;
-            move.blackQueenSideCastlingAfter = false;
-            }
-        }
+    if (move.moveType == CASTLING) {
+        int index = castlingIndex(move);
+        PieceType rook = move.piece == WHITE_KING ? WHITE_ROOK : BLACK_ROOK;
+        piece.bitboards[rook] ^= (1ULL << CASTLING_ROOK_FROM[index]) | (1ULL << CASTLING_ROOK_TO[index]);
+    }
+
+    if (state.captured != NONE)
+        piece.bitboards[state.captured] |= 1ULL << (move.moveType == EN_PASSANT ? move.to ^ 8 : move.to);
+
+#ifdef VERIFY_STATE
+    if (!(snapshot() == debugSnapshots.back())) {
+        std::cerr << "unMakeMove: the position before the move is not given back" << std::endl;
+        std::abort();
+    }
+    debugSnapshots.pop_back();
+#endif
+}
 
-    if (((move.piece == WHITE_PAWN) ^ (move.piece == BLACK_PAWN) ) && ((move.to >> 3) == 7) ^ ((move.to >> 3) == 0)) {
-       piece.bitboards[move.piece] &= ~(1ULL << move.from); // Delete Pawn
-       piece.bitboards[(move.piece == WHITE_PAWN ? WHITE_QUEEN : BLACK_QUEEN)] |= (1ULL << move.to);
-       move.enPassantSquareAfter = enPassant; 
-       currentHash = zobrist.updateHash(currentHash, move);
-       return true; // Pawn Become Queen
-    } 
 
-    bool isWhite = move.piece < 6;
+// Make and take back for the search : with copyMake the move is taken back by copying the
+// position saved before it, otherwise by unMakeMove
+void ChessBoard::doMove(Move& move, Position& saved) {
+    PROFILE_ZONE(ZONE_MAKE_MOVE);
+    if (copyMake)
+        saved = savePosition();
+    makeMove(move);
+}
 
-    if (move.piece == WHITE_KING) {
-        whiteKingSideCastling = false;
-        whiteQueenSideCastling = false;
-        move.whiteKingSideCastlingAfter = false;
-        move.whiteQueenSideCastlingAfter = false;
+void ChessBoard::undoMove(Move& move, const Position& saved) {
+    PROFILE_ZONE(ZONE_UNMAKE_MOVE);
+    if (!copyMake) {
+        unMakeMove(move);
+        return;
     }
 
-    if (move.piece == BLACK_KING) {
-        blackKingSideCastling = false;
-        blackQueenSideCastling = false;
-        move.blackKingSideCastlingAfter = false;
-        move.blackQueenSideCastlingAfter = false;
+    restorePosition(saved);
+    statePly--;
+
+#ifdef VERIFY_STATE
+    if (!(snapshot() == debugSnapshots.back())) {
+        std::cerr << "undoMove: the position before the move is not given back" << std::endl;
+        std::abort();
     }
+    debugSnapshots.pop_back();
+#endif
+}
 
-    if (move.piece == WHITE_ROOK) {
-        if (move.from == 7) {
-            whiteKingSideCastling = false;
-            move.whiteKingSideCastlingAfter = false;
-        }
-        if (move.from == 0) {
-            whiteQueenSideCastling = false;
-            move.whiteQueenSideCastlingAfter = false;
-        }
+// Leaf nodes of the legal move tree, to compare the two ways of taking back a move
+uint64_t ChessBoard::perft(int depth, bool isWhite) {
+    if (depth == 0)
+        return 1;
+
+    std::vector<Move> moves = isWhite ? allMovesForWhite() : allMovesForBlack();
+    uint64_t nodes = 0;
+    for (Move& move : moves) {
+        Position saved;
+        doMove(move, saved);
+        if (!isInCheck(isWhite))
+            nodes += perft(depth - 1, !isWhite);
+        undoMove(move, saved);
     }
+    return nodes;
+}
 
-    if (move.piece == BLACK_ROOK) {
-        if (move.from == 63) {
-            blackKingSideCastling = false;
-            move.blackKingSideCastlingAfter = false;
-        }
-        if (move.from == 56) {
-            blackQueenSideCastling = false;
-            move.blackQueenSideCastlingAfter = false;
-        }
+void ChessBoard::makeNullMove() {
+    // The side to move passes : only the side and the en passant square change
+    StateInfo& state = states[statePly++];
+    state.hash = currentHash;
+    state.pawnHash = pawnHash;
+    state.evalState = evalState;
+    state.castling = castlingRights;
+    state.enPassant = enPassant;
+    state.rule50 = rule50;
+    state.pliesFromNull = pliesFromNull;
+    state.captured = NONE;
+    rule50++;
+    pliesFromNull = 0;
+    if (nnue.isLoaded())
+        pushAccumulator(nullptr);
+
+    if (enPassant != -1)
+        currentHash ^= ZOBRIST.enPassant[enPassant + 1];
+    enPassant = -1;
+
+    currentHash ^= ZOBRIST.sideToMove;
+}
+
+void ChessBoard::unMakeNullMove() {
+    const StateInfo& state = states[--statePly];
+    if (nnue.isLoaded())
+        accumulatorPly--;
+    currentHash = state.hash;
+    enPassant = state.enPassant;
+    rule50 = state.rule50;
+    pliesFromNull = state.pliesFromNull;
+}
+
+// 100 plies without capture nor pawn move, unless the last one mated : a check is still a draw when
+// there is an evasion, even one that would take or move a pawn
+bool ChessBoard::isFiftyMoveDraw(bool isWhite) {
+    if (rule50 < 100)
+        return false;
+    if (!isInCheck(isWhite))
+        return true;
+
+    for (Move& move : evasionMoves(isWhite)) {
+        Position saved;
+        doMove(move, saved);
+        bool legal = !isInCheck(isWhite);
+        undoMove(move, saved);
+        if (legal)
+            return true;
+    }
+    return false;
+}
+
+// Same position as 4, 6, 8... plies ago, since the last capture or pawn move (and null move)
+bool ChessBoard::isRepetition() const {
+    int end = std::min(std::min(rule50, pliesFromNull), statePly);
+    for (int i = 4; i <= end; i += 2)
+        if (states[statePly - i].hash == currentHash)
+            return true;
+    return false;
+}
+
+// One move can take the board back to a position of the search (Cuckoo.h) : the side to move can at least
+// draw. Only the cycles inside the search count, before the root the move could belong to the other side.
+bool ChessBoard::hasUpcomingRepetition(uint64_t occupied) const {
+    int end = std::min(std::min(rule50, pliesFromNull), statePly - rootPly - 1);
+    for (int i = 3; i <= end; i += 2) {
+        uint64_t moveKey = currentHash ^ states[statePly - i].hash;
+        int slot = cuckooSlot1(moveKey);
+        if (CUCKOO.keys[slot] != moveKey) {
+            slot = cuckooSlot2(moveKey);
+            if (CUCKOO.keys[slot] != moveKey)
+                continue;
+        }
+
+        // The squares between must be empty
+        int move = CUCKOO.moves[slot];
+        uint64_t from = 1ULL << (move & 63);
+        uint64_t to = 1ULL << ((move >> 6) & 63);
+        int type = (move >> 12) % 6;
+        uint64_t empty = ~occupied;
+        bool pathClear = type == 1 || type == 5 ||
+                    (type != 3 && (bishopAttacks(from, empty) & to)) ||
+                    (type != 2 && (rookAttacks(from, empty) & to));
+        if (pathClear)
+            return true;
     }
+    return false;
+}
 
+bool ChessBoard::hasNonPawnMaterial(bool isWhite) {
+    return evalState.materialKey & NON_PAWN_KEY_MASK[isWhite ? 0 : 1];
+}
 
-    if (move.moveType == CASTLING) {  
 
-        // King Move :
-        piece.bitboards[move.piece] &= ~(1ULL << move.from);
-        piece.bitboards[move.piece] |= (1ULL << move.to);
+// leaf (the tuner) : the position the score comes from, the end of the principal variation
+int ChessBoard::quiescence(bool isWhite, int alpha, int beta, Piece* leaf) {
+    stats.nodes++;
+    stats.qnodes++;
+    if (leaf)
+        *leaf = piece;
 
+    // In check there is no stand pat : all the evasions are searched, and none is a mate
+    bool inCheck = isInCheck(isWhite);
+    int standPat = inCheck ? (isWhite ? -MATE_SCORE : MATE_SCORE) : evaluateCached();
+    if (!inCheck) {
+        // Stand pat : the side to move is not forced to capture
         if (isWhite) {
-            if (move.castlingType == KINGSIDE) {
-                piece.bitboards[WHITE_ROOK] &= ~(1ULL << 7); // Remove Rook
-                piece.bitboards[WHITE_ROOK] |= (1ULL << 5);
-            } else {
-                piece.bitboards[WHITE_ROOK] &= ~(1ULL << 0);
-                piece.bitboards[WHITE_ROOK] |= (1ULL << 3);
-            }
+            if (standPat >= beta)
+                return standPat;
+            alpha = std::max(alpha, standPat);
         } else {
-            if (move.castlingType == KINGSIDE) {
-                piece.bitboards[BLACK_ROOK] &= ~(1ULL << 63); // Remove Rook
-                piece.bitboards[BLACK_ROOK] |= (1ULL << 61);
-            } else {
-                piece.bitboards[BLACK_ROOK] &= ~(1ULL << 56);
-                piece.bitboards[BLACK_ROOK] |= (1ULL << 59);
-            }
-
-        }
-        move.enPassantSquareAfter = enPassant; 
-        currentHash = zobrist.updateHash(currentHash, move);
-        return false;
+            if (standPat <= alpha)
+                return standPat;
+            beta = std::min(beta, standPat);
         }
+    }
 
-        if (move.moveType == EN_PASSANT) {
-            piece.bitboards[move.piece] &= ~(1ULL << move.from);
-            piece.bitboards[move.piece] |= (1ULL << move.to);
+    // Out of check, only captures and queen promotions
+    std::vector<Move> moves = inCheck ? evasionMoves(isWhite) : (isWhite ? allMovesForWhite() : allMovesForBlack());
+    if (!inCheck) {
+        moves.erase(std::remove_if(moves.begin(), moves.end(), [](const Move& move) {
+            bool queenPromotion = move.promotion == WHITE_QUEEN || move.promotion == BLACK_QUEEN;
+            return move.capturedType == NONE && !queenPromotion;
+        }), moves.end());
+    }
+    moveOrdering(&moves);
 
-            if (isWhite) 
-                piece.bitboards[BLACK_PAWN] &= ~(1ULL << (move.to - 8));
-            else 
-                piece.bitboards[WHITE_PAWN] &= ~(1ULL << (move.to + 8));
+    std::optional<Piece> childLeaf;
+    if (leaf)
+        childLeaf.emplace();
 
-            move.enPassantSquareAfter = enPassant;
-            currentHash = zobrist.updateHash(currentHash, move);
-            return false;
+    int best = standPat;
+    for (Move& move : moves) {
+        Position saved;
+        doMove(move, saved);
+
+        if (!isInCheck(isWhite)) {
+            int eval = quiescence(!isWhite, alpha, beta, leaf ? &*childLeaf : nullptr);
+            if (isWhite ? eval > best : eval < best) {
+                best = eval;
+                if (leaf)
+                    *leaf = *childLeaf;
+            }
+            if (isWhite)
+                alpha = std::max(alpha, eval);
+            else
+                beta = std::min(beta, eval);
         }
 
+        // Undo
+        undoMove(move, saved);
 
-        if (move.piece == WHITE_PAWN && (move.to - move.from) == 16) 
-            enPassant = move.from + 8;
-        if (move.piece == BLACK_PAWN && (move.from - move.to) == 16) 
-            enPassant = move.from - 8;
+        if (beta <= alpha)
+            break;
+    }
 
-        move.enPassantSquareAfter = enPassant; 
-        // Normal Move
-        piece.bitboards[move.piece] &= ~(1ULL << move.from);
-        piece.bitboards[move.piece] |= (1ULL << move.to);
-        currentHash = zobrist.updateHash(currentHash, move);
-        return false;
+    return best;
 }
 
-void ChessBoard::unMakeMove(bool pawnBecomeQueen, Move& move) {
-    if (move.capturedType != NONE && move.moveType != EN_PASSANT)  
-        piece.bitboards[move.capturedType] |= (1ULL << move.to);
 
-    whiteKingSideCastling = move.whiteKingSideCastlingBefore;
-    whiteQueenSideCastling = move.whiteQueenSideCastlingBefore;
-    blackKingSideCastling = move.blackKingSideCastlingBefore;
-    blackQueenSideCastling = move.blackQueenSideCastlingBefore;
+bool ChessBoard::probCut(int depth, bool isWhite, int alpha, int beta, bool cutNode, int& score) {
+    int probBeta = isWhite ? beta + PROBCUT_MARGIN : alpha - PROBCUT_MARGIN;
+    int probDepth = depth - 1 - PROBCUT_REDUCTION;
 
-    enPassant = move.enPassantSquareBefore;
-    
-    if (pawnBecomeQueen) {
-        piece.bitboards[(move.piece == WHITE_PAWN ? WHITE_QUEEN : BLACK_QUEEN)] &= ~(1ULL << move.to); // Remove the Queen
-        piece.bitboards[move.piece] |= (1ULL << move.from); // Add the Pawn
-        return;
-    } 
-    
-    bool isWhite = move.piece < 6;
+    // The TT already knows that the reduced search won't beat probBeta, or a cut of an earlier ProbCut
+    auto it = transpositionTable.find(currentHash);
+    if (it != transpositionTable.end() && it->second.depth >= probDepth) {
+        const TTEntry& entry = it->second;
+        if (isWhite && entry.flag != LOWER_BOUND && entry.score < probBeta)
+            return false;
+        if (!isWhite && entry.flag != UPPER_BOUND && entry.score > probBeta)
+            return false;
+        if (entry.depth > probDepth && (isWhite ? entry.flag != UPPER_BOUND && entry.score >= probBeta
+                                                : entry.flag != LOWER_BOUND && entry.score <= probBeta)) {
+            score = entry.score;
+            return true;
+        }
+    }
 
-    if (move.moveType == CASTLING) {
-        // For the King
-        piece.bitboards[move.piece] |= (1ULL << move.from);
-        piece.bitboards[move.piece] &= ~(1ULL << move.to);
+    std::vector<Move> moves = isWhite ? allMovesForWhite() : allMovesForBlack();
+    moveOrdering(&moves);
 
-        if (isWhite) {
-            if (move.castlingType == KINGSIDE) {
-                piece.bitboards[WHITE_ROOK] |= (1ULL << 7);
-                piece.bitboards[WHITE_ROOK] &= ~(1ULL << 5);
-            } else {
-                piece.bitboards[WHITE_ROOK] |= (1ULL << 0);
-                piece.bitboards[WHITE_ROOK] &= ~(1ULL << 3);
-            }
-        } else {
-            if (move.castlingType == KINGSIDE) {
-                piece.bitboards[BLACK_ROOK] |= (1ULL << 63);
-                piece.bitboards[BLACK_ROOK] &= ~(1ULL << 61);
-            } else {
-                piece.bitboards[BLACK_ROOK] |= (1ULL << 56);
-                piece.bitboards[BLACK_ROOK] &= ~(1ULL << 59);
+    for (Move& move : moves) {
+        // Only captures that win material at first sight
+        if (move.capturedType == NONE || PIECE_VALUE[move.capturedType] < PIECE_VALUE[move.piece])
+            continue;
+
+        Position saved;
+        doMove(move, saved);
+
+        if (!isInCheck(isWhite)) {
+            // Without depth left, the quiescence search still sees the recapture
+            int eval;
+            if (isWhite)
+                eval = probDepth > 0 ? alphaBeta<NON_PV>(probDepth, false, probBeta - 1, probBeta, !cutNode)
+                                     : quiescence(false, probBeta - 1, probBeta);
+            else
+                eval = probDepth > 0 ? alphaBeta<NON_PV>(probDepth, true, probBeta, probBeta + 1, !cutNode)
+                                     : quiescence(true, probBeta, probBeta + 1);
+
+            if (isWhite ? eval >= probBeta : eval <= probBeta) {
+                undoMove(move, saved);
+                score = eval;
+
+                // A bound of the node as deep as the reduced search, unless the TT knows it deeper
+                auto stored = transpositionTable.find(currentHash);
+                if (stored == transpositionTable.end() || stored->second.depth <= probDepth + 1) {
+                    TTEntry tt;
+                    tt.score = eval;
+                    tt.depth = probDepth + 1;
+                    tt.flag = isWhite ? LOWER_BOUND : UPPER_BOUND;
+                    stats.ttStores++;
+                    if (!transpositionTable.insert_or_assign(currentHash, tt).second)
+                        stats.ttOverwrites++;
+                }
+                return true;
             }
         }
-    } else if (move.moveType == EN_PASSANT) {
-        piece.bitboards[move.piece] |= (1ULL << move.from);
-        piece.bitboards[move.piece] &= ~(1ULL << move.to);
 
-        if (isWhite) 
-            piece.bitboards[BLACK_PAWN] |= (1ULL << (move.to - 8));
-        else 
-            piece.bitboards[WHITE_PAWN] |= (1ULL << (move.to + 8));
-
-    }
-    
-    
-    else {
-        piece.bitboards[move.piece] |= (1ULL << move.from);
-        piece.bitboards[move.piece] &= ~(1ULL << move.to);
+        // Undo
+        undoMove(move, saved);
     }
 
-    currentHash = hashHistory.back();
-    hashHistory.pop_back();
-    
+    return false;
 }
 
+bool ChessBoard::multiCut(int depth, bool isWhite, int alpha, int beta) {
+    int reducedDepth = depth - 1 - MULTI_CUT_REDUCTION;
+    int tried = 0;
+    int cutoffs = 0;
 
-int ChessBoard::alphaBeta(int depth, bool isWhite, int alpha, int beta) {
-    counter_alpha_beta++;
-    bool cutoff = false;
+    std::vector<Move> moves = isWhite ? allMovesForWhite() : allMovesForBlack();
+    moveOrdering(&moves);
 
-    auto it = transpositionTable.find(currentHash);
-    if (it != transpositionTable.end() && it->second.depth >= depth) {
-        counter_same_hash++;
-        return it->second.score;
-    }
+    for (Move& move : moves) {
+        if (tried == MULTI_CUT_MOVES)
+            break;
 
-    if (depth == 0) {
-        int score = evaluatePawnPower();
-        TTEntry tt;
-        tt.score = score;
-        tt.depth = depth;
-        transpositionTable[currentHash] = tt;  
-        
-        return score;
+        Position saved;
+        doMove(move, saved);
+
+        if (!isInCheck(isWhite)) {
+            tried++;
+            int eval = reducedDepth > 0 ? alphaBeta<NON_PV>(reducedDepth, !isWhite, alpha, beta, false)
+                                        : quiescence(!isWhite, alpha, beta);
+            if (isWhite ? eval >= beta : eval <= alpha)
+                cutoffs++;
+        }
+
+        // Undo
+        undoMove(move, saved);
+
+        if (cutoffs == MULTI_CUT_CUTOFFS)
+            return true;
     }
 
-    bool hasLegalMove = false;
-    if (isWhite) {
-        int max_ = -1000;
+    return false;
+}
 
-        std::vector<Move> moves = allMovesForWhite();
-        moveOrdering(&moves);
-        
-        for (Move& move : moves) {
 
-            bool pawnBecomeQueen = makeMove(move);
+// ROOT : keeps the best move, nothing is cut before all its moves are searched.
+// PV : full window, its first move is searched as PV and the others with a null window first (PVS).
+// NON_PV : null window, the only nodes with null move, ProbCut and multi-cut.
+// cutNode : a NON_PV node expected to fail high, the null window reply of a PV node, then every other ply
+// (the replies to an expected cut are expected all-nodes). Only expected cut nodes try multi-cut.
+template <NodeType nodeType>
+int ChessBoard::alphaBeta(int depth, bool isWhite, int alpha, int beta, bool cutNode, bool nullMoveAllowed) {
+    constexpr bool rootNode = nodeType == ROOT;
+    constexpr bool pvNode = nodeType != NON_PV;
+    stats.nodes++;
 
-            if (!isInCheck(true)) {
-                hasLegalMove = true;
-                int eval = alphaBeta(depth -1, false, alpha, beta);
-                alpha = std::max(alpha, eval);
-                max_ = std::max(max_, eval);
+    uint64_t occupied = 0;
+    for (int i = 0; i < 12; ++i)
+        occupied |= piece.bitboards[i];
+
+    int bitbaseScore = 0;
+    bool bitbaseHit = false;
+
+    if (!rootNode) {
+        // Draws : a position seen before, or 50 moves without capture nor pawn move (unless it's a mate)
+        if (isRepetition() || isFiftyMoveDraw(isWhite)) {
+            stats.drawCutoffs++;
+            return 0;
+        }
+
+        // The side to move can go back to a position of the search : it doesn't have to accept less than a draw
+        if (hasUpcomingRepetition(occupied)) {
+            if (isWhite)
+                alpha = std::max(alpha, 0);
+            else
+                beta = std::min(beta, 0);
+            if (alpha >= beta) {
+                stats.drawCutoffs++;
+                return 0;
             }
-            
-            // Undo
-            unMakeMove(pawnBecomeQueen, move);
+        }
+    }
 
-            if (beta <= alpha) {
-                cutoff = true;
-                break;
+    int alphaOrig = alpha;
+    int betaOrig = beta;
+
+    // Only exact scores in PV nodes : a bound would cut the principal variation short
+    if (!rootNode) {
+        stats.ttProbes++;
+        auto it = transpositionTable.find(currentHash);
+        if (it != transpositionTable.end() && it->second.depth >= depth) {
+            const TTEntry& entry = it->second;
+            stats.ttHits++;
+            if (entry.flag == EXACT ||
+                (!pvNode && entry.flag == LOWER_BOUND && entry.score >= beta) ||
+                (!pvNode && entry.flag == UPPER_BOUND && entry.score <= alpha)) {
+                stats.ttCutoffs++;
+                return entry.score;
             }
+        }
 
+        // Bitbase endgames : draws and distances to mate are cut at once. Without the distances, wins are cut
+        // when material came off during the search : when the game is already in the bitbase they only score
+        // the leaves and the search looks for the mate.
+        bool bitbaseExact = false;
+        bitbaseHit = __builtin_popcountll(occupied) <= 4 && probeBitbase(isWhite, depth, bitbaseScore, bitbaseExact);
+        if (bitbaseHit && (bitbaseScore == 0 || bitbaseExact || !bitbaseRoot || depth == 0)) {
+            stats.bitbaseCutoffs++;
+            return bitbaseScore;
         }
 
-        if (!hasLegalMove) {
-            if (isInCheck(true))
-                return -10000 - depth; // Mat
-            else
-                return 0; // Pat
+        // Leaves only go to the evaluation cache, the TT keeps the search results
+        if (depth == 0)
+            return evaluateCached();
+    }
+
+    bool inCheck = isInCheck(isWhite);
+    int staticEval = 0;
+    bool futile = false;
 
+    if (!rootNode && !inCheck) {
+        staticEval = bitbaseHit ? bitbaseScore : evaluateCached();
+        // Not in PV nodes : their scores must be exact, a margin or a razoring bound is not
+        bool shallow = !pvNode && !bitbaseHit && depth <= SHALLOW_PRUNING_MAX_DEPTH;
+
+        // Reverse futility : the static evaluation is so far above beta (below alpha for black)
+        // that no quiet reply at this depth is expected to bring it back
+        if (shallow && (isWhite ? staticEval - REVERSE_FUTILITY_MARGIN[depth] >= beta
+                                : staticEval + REVERSE_FUTILITY_MARGIN[depth] <= alpha)) {
+            stats.reverseFutility++;
+            return isWhite ? staticEval - REVERSE_FUTILITY_MARGIN[depth] : staticEval + REVERSE_FUTILITY_MARGIN[depth];
         }
-        if (!cutoff) {
-            TTEntry tt;
-            tt.score = max_;
-            tt.depth = depth;
-            transpositionTable[currentHash] = tt;
+
+        // Razoring : hopeless positions only get a quiescence search to confirm it
+        if (shallow) {
+            if (isWhite && staticEval + RAZORING_MARGIN[depth] <= alpha) {
+                int eval = quiescence(true, alpha, alpha + 1);
+                if (eval <= alpha) {
+                    stats.razoring++;
+                    return eval;
+                }
+            }
+            if (!isWhite && staticEval - RAZORING_MARGIN[depth] >= beta) {
+                int eval = quiescence(false, beta - 1, beta);
+                if (eval >= beta) {
+                    stats.razoring++;
+                    return eval;
+                }
+            }
         }
-        return max_;
-    } else {
-        int min_ = 1000;
 
-        std::vector<Move> moves = allMovesForBlack();
-        moveOrdering(&moves);
+        // Futility : quiet moves can't bring the score back into the window
+        futile = shallow && (isWhite ? staticEval + FUTILITY_MARGIN[depth] <= alpha
+                                     : staticEval - FUTILITY_MARGIN[depth] >= beta);
+    }
+
+    if (!pvNode && !inCheck) {
+        // Null move : give the opponent a free move, if we are still above beta (below alpha for black)
+        // the position is good enough to be cut. Without pieces (only pawns) zugzwang is likely,
+        // so the cut is verified by a normal reduced search.
+        if (nullMoveAllowed && depth >= NULL_MOVE_MIN_DEPTH) {
+            int nullDepth = depth - 1 - NULL_MOVE_REDUCTION;
 
-        for (Move& move : moves) {
-            bool pawnBecomeQueen = makeMove(move);
+            if (isWhite && staticEval >= beta) {
+                makeNullMove();
+                int eval = alphaBeta<NON_PV>(nullDepth, false, beta - 1, beta, !cutNode, false);
+                unMakeNullMove();
 
-            if (!isInCheck(false)) {
-                hasLegalMove = true;
-                int eval = alphaBeta(depth -1, true, alpha, beta);
-                min_ = std::min(min_, eval);
-                beta = std::min(beta, eval);   
+                if (eval >= beta && (hasNonPawnMaterial(true) || alphaBeta<NON_PV>(nullDepth, true, beta - 1, beta, false, false) >= beta)) {
+                    stats.nullMove++;
+                    return beta;
+                }
             }
-            
-            // Undo
-            unMakeMove(pawnBecomeQueen, move);
 
-            if (beta <= alpha) {
-                cutoff = true;
-                break;
+            if (!isWhite && staticEval <= alpha) {
+                makeNullMove();
+                int eval = alphaBeta<NON_PV>(nullDepth, true, alpha, alpha + 1, !cutNode, false);
+                unMakeNullMove();
+
+                if (eval <= alpha && (hasNonPawnMaterial(false) || alphaBeta<NON_PV>(nullDepth, false, alpha, alpha + 1, false, false) <= alpha)) {
+                    stats.nullMove++;
+                    return alpha;
+                }
             }
         }
 
-        if (!hasLegalMove) {
-            if (isInCheck(false))
-                return 10000 + depth; // Mat
-            else
-                return 0; // Pat
+        // ProbCut : a good capture that beats beta by a margin in a reduced search
+        // will very likely beat beta in the full search
+        if (depth >= PROBCUT_MIN_DEPTH) {
+            int score;
+            if (probCut(depth, isWhite, alpha, beta, cutNode, score)) {
+                stats.probCut++;
+                return score;
+            }
         }
-        if (!cutoff) {
-            TTEntry tt;
-            tt.score = min_;
-            tt.depth = depth;
-            transpositionTable[currentHash] = tt;
+
+        // Multi-cut : several moves already fail high in a reduced search (at an all-node it would only cost)
+        if (cutNode && depth >= MULTI_CUT_MIN_DEPTH && multiCut(depth, isWhite, alpha, beta)) {
+            stats.multiCut++;
+            return isWhite ? beta : alpha;
         }
-        return min_;
     }
- }
 
+    if (rootNode)
+        rootBestMove.from = -1;
 
-void ChessBoard::AI_chess(bool AIplaysBlack) {
-    int depth = 6;
-    bool hasLegalMove = false;
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    
-    std::vector<Move> moves;
-    int max_;
-    int min_;
+    std::vector<Move> moves = inCheck ? evasionMoves(isWhite) : (isWhite ? allMovesForWhite() : allMovesForBlack());
+    moveOrdering(&moves);
 
-    if (AIplaysBlack) {
-        min_ = 1000;
-        moves = allMovesForBlack();
-    } else {
-        max_ = -1000;
-        moves = allMovesForWhite();
-        }
+    int best = isWhite ? -INFINITE_SCORE : INFINITE_SCORE;
+    int moveIndex = 0;
 
-    Move move_;
     for (Move& move : moves) {
+        Position saved;
+        doMove(move, saved);
 
-        bool pawnBecomeQueen = makeMove(move);
+        if (isInCheck(isWhite)) {
+            undoMove(move, saved);
+            continue;
+        }
 
-        if (!isInCheck(!AIplaysBlack)) {
+        bool quiet = move.capturedType == NONE && move.moveType != PROMOTION;
+        bool givesCheck = quiet && isInCheck(!isWhite);
 
-            if (!hasLegalMove) {
-                move_ = move;
-            }
-            hasLegalMove = true;
-            int eval;
-            if (AIplaysBlack) {
-                eval = alphaBeta(depth, true, -1000, 1000); 
-            } else {
-                eval = alphaBeta(depth, false, -1000, 1000); 
+        if (futile && quiet && !givesCheck && moveIndex > 0) {
+            int bound = isWhite ? staticEval + FUTILITY_MARGIN[depth] : staticEval - FUTILITY_MARGIN[depth];
+            best = isWhite ? std::max(best, bound) : std::min(best, bound);
+            stats.futility++;
+            moveIndex++;
+            undoMove(move, saved);
+            continue;
+        }
+
+        // Null window of the side to move : can the move beat alpha (white) or beta (black) ?
+        int nullAlpha = isWhite ? alpha : beta - 1;
+        int nullBeta = nullAlpha + 1;
+        int eval;
+
+        if (pvNode && moveIndex == 0) {
+            eval = alphaBeta<PV>(depth - 1, !isWhite, alpha, beta);
+        } else {
+            // Late move reduction : quiet moves ordered late are searched with less depth,
+            // then searched again at full depth if they beat the window
+            int reducedDepth = depth - 1;
+            if (!rootNode && depth >= LMR_MIN_DEPTH && moveIndex >= LMR_MIN_MOVE_INDEX && quiet && !inCheck && !givesCheck) {
+                int reduction = lmrReductions[std::min(depth, MAX_DEPTH - 1)][std::min(moveIndex, MAX_MOVES - 1)];
+                reducedDepth = std::max(1, depth - 1 - reduction);
+                if (reducedDepth < depth - 1)
+                    stats.lmrReductions++;
             }
 
-            if (AIplaysBlack) {
-                if (eval < min_) {
-                    move_ = move;
-                    min_ = eval;
-                    }
-            } else {
-                if (eval > max_) {
-                    move_ = move;
-                    max_ = eval;
-                    }
+            eval = alphaBeta<NON_PV>(reducedDepth, !isWhite, nullAlpha, nullBeta, !cutNode);
+            bool beatsWindow = isWhite ? eval > alpha : eval < beta;
+            if (beatsWindow && reducedDepth < depth - 1) {
+                stats.lmrResearches++;
+                eval = alphaBeta<NON_PV>(depth - 1, !isWhite, nullAlpha, nullBeta, !cutNode);
             }
 
+            // Inside the window of a PV node : the exact score is needed
+            if (pvNode && eval > alpha && eval < beta)
+                eval = alphaBeta<PV>(depth - 1, !isWhite, alpha, beta);
         }
 
-        // Undo
-        unMakeMove(pawnBecomeQueen, move);
+        undoMove(move, saved);
+        moveIndex++;
+
+        bool improves = isWhite ? eval > best : eval < best;
+        if (improves) {
+            best = eval;
+            if (rootNode)
+                rootBestMove = move;
+        }
+        if (rootNode && rootBestMove.from == -1)
+            rootBestMove = move;
+
+        if (isWhite)
+            alpha = std::max(alpha, eval);
+        else
+            beta = std::min(beta, eval);
+
+        if (beta <= alpha) {
+            stats.betaCutoffs++;
+            if (moveIndex == 1)
+                stats.firstMoveCutoffs++;
+            break;
+        }
+    }
+
+    if (moveIndex == 0) {
+        if (inCheck)
+            return isWhite ? -MATE_SCORE - depth : MATE_SCORE + depth; // Mat
+        return 0; // Pat
+    }
+
+    TTEntry tt;
+    tt.score = best;
+    tt.depth = depth;
+    tt.flag = best <= alphaOrig ? UPPER_BOUND : (best >= betaOrig ? LOWER_BOUND : EXACT);
+    stats.ttStores++;
+    if (!transpositionTable.insert_or_assign(currentHash, tt).second)
+        stats.ttOverwrites++;
+    return best;
+}
+
+template int ChessBoard::alphaBeta<ROOT>(int depth, bool isWhite, int alpha, int beta, bool cutNode, bool nullMoveAllowed);
+template int ChessBoard::alphaBeta<PV>(int depth, bool isWhite, int alpha, int beta, bool cutNode, bool nullMoveAllowed);
+template int ChessBoard::alphaBeta<NON_PV>(int depth, bool isWhite, int alpha, int beta, bool cutNode, bool nullMoveAllowed);
+
+
+// e2e4, e7e8q
+static std::string uciMove(const Move& move) {
+    std::string text = {static_cast<char>('a' + move.from % 8), static_cast<char>('1' + move.from / 8),
+                        static_cast<char>('a' + move.to % 8), static_cast<char>('1' + move.to / 8)};
+    if (move.moveType == PROMOTION)
+        text += " pnbrqk"[move.promotion % 6 + 1];
+    return text;
+}
+
+void ChessBoard::AI_chess(bool AIplaysBlack) {
+    int depth = 6;
+    bool hasLegalMove = false;
+    bool searched = false;
+    auto start = std::chrono::high_resolution_clock::now();
+    stats = SearchStats();
+
+    std::vector<Move> moves = AIplaysBlack ? allMovesForBlack() : allMovesForWhite();
+
+    trimStates();
+    rootPly = statePly;
+
+    Move move_;
+    int bitbaseScore;
+    bool bitbaseExact;
+    bitbaseRoot = probeBitbase(!AIplaysBlack, depth, bitbaseScore, bitbaseExact) && !bitbaseExact;
+
+    // The book knows the opening : no search
+    if (probeBook(!AIplaysBlack, moves, move_)) {
+        hasLegalMove = true;
+        std::cout << "Book move" << std::endl;
+    } else {
+        // The root move, then depth plies below it
+        auto searchStart = std::chrono::high_resolution_clock::now();
+        stats.depth = depth + 1;
+        stats.white = !AIplaysBlack;
+#ifdef PROFILE_ZONES
+        profileCounters = ProfileCounters();
+#endif
+        {
+            PROFILE_ZONE(ZONE_SEARCH);
+            stats.score = alphaBeta<ROOT>(depth + 1, !AIplaysBlack, -INFINITE_SCORE, INFINITE_SCORE);
+        }
+        stats.searchSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - searchStart).count();
+        hasLegalMove = rootBestMove.from != -1;
+        move_ = rootBestMove;
+        searched = true;
+        if (hasLegalMove)
+            stats.bestMove = uciMove(move_);
     }
 
     if (!hasLegalMove) {
@@ -2233,13 +2321,13 @@ void ChessBoard::AI_chess(bool AIplaysBlack) {
     hasLegalMove = false;
 
     for (Move& myMove : myPossiblesMoves) {
-        bool pawnBecomeQueen = makeMove(myMove);
+        makeMove(myMove);
         if (!isInCheck(AIplaysBlack)) {
            hasLegalMove = true;
-            unMakeMove(pawnBecomeQueen, myMove);
+            unMakeMove(myMove);
             break;  
         }
-        unMakeMove(pawnBecomeQueen, myMove);
+        unMakeMove(myMove);
     }
 
     if (!hasLegalMove) {
@@ -2254,69 +2342,23 @@ void ChessBoard::AI_chess(bool AIplaysBlack) {
 
 
     }
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+    stats.ttSize = transpositionTable.size();
+    stats.totalSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
 
-    if (transpositionTable.size() > 100000) {
+    if (transpositionTable.size() > 100000)
         transpositionTable.clear();
-        hashHistory.clear();
-    }
-
-    std::cout << "size transpositionTable : " << transpositionTable.size() << std::endl;
-    //transpositionTable.clear();
-    std::cout << "size transpositionTable  : " << transpositionTable.size() << " counter_same_hash :"<< counter_same_hash << std::endl;
-    std::cout << "counter_alpha_beta " << counter_alpha_beta << std::endl;
-    std::cout << "time : " << duration.count() / 1000.0f << " s" << std::endl;
-    std::cout << std::endl;
-    counter_alpha_beta = 0;
-    counter_same_hash = 0;
-
-    std::cout << "=== TEST HASH ===" << std::endl;
-    
-    //uint64_t hashInitial = currentHash;
-    //std::cout << "Hash initial: " << hashInitial << std::endl;
-    
-    // Génère tous les coups blancs
 
-    /*
-    moves = allMovesForWhite();
-    
-    if (moves.size() > 0) {
-        Move& testMove = moves[0];
-        
-        // Fait le coup
-        bool pawn = makeMove(testMove);
-        uint64_t hashAfterMove = currentHash;
-        std::cout << "Hash après coup: " << hashAfterMove << std::endl;
-        
-        // Annule le coup
-        unMakeMove(pawn, testMove);
-        uint64_t hashAfterUndo = currentHash;
-        std::cout << "Hash après undo: " << hashAfterUndo << std::endl;
-        
-        // Vérifie
-        if (hashInitial == hashAfterUndo) {
-            std::cout << "✅ HASH CORRECT après undo" << std::endl;
-        } else {
-            std::cout << "❌ HASH FAUX après undo !" << std::endl;
-            std::cout << "Différence: " << (hashInitial - hashAfterUndo) << std::endl;
-        }
-        
-        // Test 2 : Refaire le même coup doit donner le même hash
-        bool pawn2 = makeMove(testMove);
-        uint64_t hashSecondMove = currentHash;
-        
-        if (hashAfterMove == hashSecondMove) {
-            std::cout << "✅ HASH IDENTIQUE pour le même coup" << std::endl;
-        } else {
-            std::cout << "❌ HASH DIFFÉRENT pour le même coup !" << std::endl;
+    if (searched) {
+        std::cout << stats.toInfo() << std::endl;
+#ifdef PROFILE_ZONES
+        std::cout << profileReport(profileCounters);
+#endif
+        if (!statsPath.empty()) {
+            std::ofstream file(statsPath, std::ios::app);
+            file << stats.toJson() << "\n";
         }
-        
-        unMakeMove(pawn2, testMove);
     }
-    
-    std::cout << "=== FIN TEST ===" << std::endl;
-    */
+    std::cout << std::endl;
 }
 
 
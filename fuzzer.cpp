@@ -0,0 +1,147 @@
+// Random make / unmake sequences that catch any drift of the incremental state
+// (hashes, castling rights, en passant, evaluation state, material key, NNUE accumulators).
+//
+// Usage : fuzzer [games] [plies] [seed] [network]
+//
+// Each game starts from one of the positions below and plays random legal moves, with some null moves
+// and some moves taken back on the way (by unMakeMove, or by copy-make one game out of two). After each
+// move the state is compared with the state computed from the bitboards, after each take back with the
+// snapshot taken before the move. At the end the game is unwound and the starting snapshot must come back.
+// Built with -DVERIFY_STATE, makeMove and unMakeMove also check themselves at every call.
+
+#include "Headers/chessboard.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Castling, en passant, promotions, checks and pawn endings
+static const char* POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+    "4k3/1P6/8/8/8/8/6p1/4K3 b - - 0 1"
+};
+constexpr int POSITION_COUNT = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+
+struct PlayedMove {
+    Move move;
+    bool nullMove = false;
+    Position saved; // For copy-make
+    BoardSnapshot before;
+};
+
+static std::vector<Move> legalMoves(ChessBoard& board, bool whiteToMove) {
+    std::vector<Move> moves = whiteToMove ? board.allMovesForWhite() : board.allMovesForBlack();
+    std::vector<Move> legal;
+    for (Move& move : moves) {
+        board.makeMove(move);
+        if (!board.isInCheck(whiteToMove))
+            legal.push_back(move);
+        board.unMakeMove(move);
+    }
+    return legal;
+}
+
+static void takeBack(ChessBoard& board, PlayedMove& played) {
+    if (played.nullMove)
+        board.unMakeNullMove();
+    else
+        board.undoMove(played.move, played.saved);
+}
+
+int main(int argc, char** argv) {
+    int games = argc > 1 ? std::stoi(argv[1]) : 1000;
+    int plies = std::min(argc > 2 ? std::stoi(argv[2]) : 200, STATE_STACK_SIZE - 1); // No trimStates() here
+    uint64_t seed = argc > 3 ? std::stoull(argv[3]) : 1;
+
+    sf::RenderWindow window; // Never opened
+    std::unique_ptr<ChessBoard> board = std::make_unique<ChessBoard>(800, 800, 8, window);
+    if (argc > 4 && !board->loadNetwork(argv[4]))
+        return 1;
+
+    std::mt19937_64 rng(seed);
+    long moveCount = 0;
+    int failures = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int game = 0; game < games && failures < 10; ++game) {
+        bool whiteToMove;
+        const char* fen = POSITIONS[game % POSITION_COUNT];
+        board->loadFen(fen, whiteToMove);
+        board->copyMake = game % 2 == 1; // One game out of two takes its moves back by copy
+        BoardSnapshot initial = board->snapshot();
+        std::vector<PlayedMove> played;
+        std::string error;
+
+        auto fail = [&](const std::string& what) {
+            std::cerr << "Game " << game << " (" << fen << "), ply " << played.size() << " : " << what << std::endl;
+            failures++;
+        };
+
+        for (int ply = 0; ply < plies && failures == 0; ++ply) {
+            // Sometimes go back a few moves before going on
+            if (!played.empty() && rng() % 8 == 0) {
+                int count = 1 + static_cast<int>(rng() % 3);
+                for (int i = 0; i < count && !played.empty(); ++i) {
+                    takeBack(*board, played.back());
+                    whiteToMove = !whiteToMove;
+                    if (!(board->snapshot() == played.back().before))
+                        fail("take back doesn't give back the position");
+                    played.pop_back();
+                }
+                continue;
+            }
+
+            std::vector<Move> moves = legalMoves(*board, whiteToMove);
+            if (moves.empty())
+                break;
+
+            PlayedMove current;
+            current.before = board->snapshot();
+            if (rng() % 16 == 0 && !board->isInCheck(whiteToMove)) {
+                current.nullMove = true;
+                board->makeNullMove();
+            } else {
+                current.move = moves[rng() % moves.size()];
+                board->doMove(current.move, current.saved);
+            }
+            played.push_back(current);
+            whiteToMove = !whiteToMove;
+            moveCount++;
+
+            // Computes the NNUE accumulator of the new position, so that it is compared too
+            board->evaluatePawnPower();
+
+            if (!board->verifyState(whiteToMove, error)) {
+                const Move& move = current.move;
+                fail(current.nullMove ? "null move : " + error
+                                      : "move " + std::to_string(move.from) + "-" + std::to_string(move.to) + " : " + error);
+            }
+        }
+
+        while (!played.empty() && failures == 0) {
+            takeBack(*board, played.back());
+            whiteToMove = !whiteToMove;
+            if (!(board->snapshot() == played.back().before))
+                fail("take back doesn't give back the position");
+            played.pop_back();
+        }
+
+        if (failures == 0 && !(board->snapshot() == initial))
+            fail("the starting position doesn't come back");
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    std::cout << "Moves : " << moveCount << " in " << seconds << " s, failures : " << failures << std::endl;
+    return failures == 0 ? 0 : 1;
+}
@@ -1,13 +1,32 @@
 #include <SFML/Graphics.hpp>
 #include "Headers/chessboard.h"
+#include "Headers/Benchmark.h"
+#include "Headers/Cpu.h"
 #include <bitset>
 #include <iostream>
 #include <optional>
 #include <functional>
+#include <memory>
+#include <string>
 
 
-int main()
+// chess_ai bench [depth] [cpu level] : make / unmake against copy-make, without opening the window
+static int bench(int argc, char** argv) {
+    for (CpuLevel level : {CPU_GENERIC, CPU_POPCNT, CPU_BMI2})
+        if (argc > 3 && std::string(argv[3]) == cpuLevelName(level))
+            setCpuLevel(level);
+
+    sf::RenderWindow window; // Never opened
+    std::unique_ptr<ChessBoard> board = std::make_unique<ChessBoard>(800, 800, 8, window);
+    board->loadNetwork("network.nnue");
+    return runBenchmark(*board, argc > 2 ? std::stoi(argv[2]) : 6) ? 0 : 1;
+}
+
+int main(int argc, char** argv)
 {
+    if (argc > 1 && std::string(argv[1]) == "bench")
+        return bench(argc, argv);
+
     std::string name_window = "chess AI";
     int number = 10;
     int windowSize = 1000;
@@ -15,6 +34,15 @@ int main()
 
     ChessBoard board(windowSize, windowSize, 8, window);  // creation of the class to display the board
 
+    // Optional : without a network the classical evaluation is used
+    board.loadNetwork("network.nnue");
+    board.loadBook("book.bin");
+    board.loadBitbases("bitbases"); // Written by bitbase_generator
+
+    // chess_ai --stats file : the statistics of each search are appended to the file, one JSON object per line
+    if (argc > 2 && std::string(argv[1]) == "--stats")
+        board.statsPath = argv[2];
+
     // AI
     bool AIisBlack = true;
 
@@ -114,10 +142,10 @@ int main()
                             std::vector<Move> moves = board.allMovesForWhite();
 
                             for (Move& move : moves) {
-                                bool pawn = board.makeMove(move);
+                                board.makeMove(move);
                                 if (board.piece.bitboards[move.piece] == *pieceLeftClick && move.from == position && !board.isInCheck(true))
                                     possibilityMove_ |= (1ULL << move.to);
-                                board.unMakeMove(pawn, move);
+                                board.unMakeMove(move);
                             }
                               
                         }                            
@@ -163,7 +191,11 @@ int main()
                     } else {
                         positionrightClick2 = board.mouseToPosition(x, y, size);
                         std::cout << "Put piece here : " << positionrightClick2 << std::endl;
+                        for (uint64_t& bitboard : board.piece.bitboards) // The piece replaces the one already there
+                            bitboard &= ~(1ULL << positionrightClick2);
                         *piece |= (1ULL << positionrightClick2);
+                        board.enPassant = -1;
+                        board.resetState(true); // Hashes and evaluation were not updated by the edition
                         window.setTitle("Put piece here");
                     }
                      
@@ -0,0 +1,219 @@
+// Times the primitives of the engine one by one over a fixed set of positions (the perft positions and a few
+// middlegames) : the move generators of each piece, allMovesForWhite / Black, isAttacked, isInCheck,
+// makeMove + unMakeMove, updateHash, moveOrdering and evaluatePawnPower.
+//
+// Usage : microbench [trials] [filter] [cpu level] [network]
+//
+// Each primitive is first repeated until a pass over the positions takes MIN_TRIAL_SECONDS (the warm-up, which
+// also fills the caches of the evaluation), then timed as many trials with that repeat count. The best trial
+// gives ns/op and ops/s, the median shows how stable it is. The loading of the positions is not timed.
+// filter runs only the primitives whose name contains it, cpu level is generic, popcnt or bmi2 (as chess_ai bench).
+
+#include "Headers/chessboard.h"
+#include "Headers/Cpu.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+static const char* POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bq1rk1/pp2bppp/2n1pn2/2pp4/3P4/2PBPN2/PP1N1PPP/R1BQ1RK1 b - - 3 8",
+    "2r3k1/5pp1/p3p2p/1p1qP3/3P4/P4Q1P/1P3PP1/2R3K1 b - - 0 28"
+};
+constexpr int POSITION_COUNT = sizeof(POSITIONS) / sizeof(POSITIONS[0]);
+
+constexpr double MIN_TRIAL_SECONDS = 0.05;
+constexpr int MAX_MOVES_OF_A_PIECE = 64;
+
+// What a primitive needs from a position, computed once
+struct PositionData {
+    std::string fen;
+    bool whiteToMove;
+    std::vector<int> squares[12]; // By PieceType
+    std::vector<Move> moves;      // Pseudo-legal, of the side to move
+};
+
+// One pass over the inputs of the loaded position, returns the operations done
+using PassFunction = std::function<long(ChessBoard&, PositionData&)>;
+
+struct Primitive {
+    std::string name;
+    PassFunction pass;
+};
+
+static volatile uint64_t sink; // The results go there, so that nothing is optimised away
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// A generator of one piece type on all its squares
+static Primitive generator(const std::string& name, PieceType type, int (ChessBoard::*possibility)(int, int*)) {
+    return {name, [type, possibility](ChessBoard& board, PositionData& data) {
+        int moves[MAX_MOVES_OF_A_PIECE];
+        long count = 0;
+        for (int square : data.squares[type])
+            count += (board.*possibility)(square, moves);
+        sink += count;
+        return static_cast<long>(data.squares[type].size());
+    }};
+}
+
+static std::vector<Primitive> primitives() {
+    std::vector<Primitive> list = {
+        generator("possibilityWhitePawn", WHITE_PAWN, &ChessBoard::possibilityWhitePawn),
+        generator("possibilityBlackPawn", BLACK_PAWN, &ChessBoard::possibilityBlackPawn),
+        generator("possibilityWhiteKnight", WHITE_KNIGHT, &ChessBoard::possibilityWhiteKnight),
+        generator("possibilityBlackKnight", BLACK_KNIGHT, &ChessBoard::possibilityBlackKnight),
+        generator("possibilityWhiteBishop", WHITE_BISHOP, &ChessBoard::possibilityWhiteBishop),
+        generator("possibilityBlackBishop", BLACK_BISHOP, &ChessBoard::possibilityBlackBishop),
+        generator("possibilityWhiteTower", WHITE_ROOK, &ChessBoard::possibilityWhiteTower),
+        generator("possibilityBlackTower", BLACK_ROOK, &ChessBoard::possibilityBlackTower),
+        generator("possibilityWhiteQueen", WHITE_QUEEN, &ChessBoard::possibilityWhiteQueen),
+        generator("possibilityBlackQueen", BLACK_QUEEN, &ChessBoard::possibilityBlackQueen),
+        generator("possibilityWhiteKing", WHITE_KING, &ChessBoard::possibilityWhiteKing),
+        generator("possibilityBlackKing", BLACK_KING, &ChessBoard::possibilityBlackKing)
+    };
+
+    list.push_back({"allMovesForWhite", [](ChessBoard& board, PositionData&) {
+        sink += board.allMovesForWhite().size();
+        return 1L;
+    }});
+    list.push_back({"allMovesForBlack", [](ChessBoard& board, PositionData&) {
+        sink += board.allMovesForBlack().size();
+        return 1L;
+    }});
+
+    // Every square, attacked by the opponent of the side to move
+    list.push_back({"isAttacked", [](ChessBoard& board, PositionData& data) {
+        long attacked = 0;
+        for (int square = 0; square < 64; ++square)
+            attacked += board.isAttacked(square, data.whiteToMove);
+        sink += attacked;
+        return 64L;
+    }});
+    list.push_back({"isInCheck", [](ChessBoard& board, PositionData&) {
+        sink += board.isInCheck(true) + board.isInCheck(false);
+        return 2L;
+    }});
+
+    // A make and its unmake are one operation
+    list.push_back({"makeMove+unMakeMove", [](ChessBoard& board, PositionData& data) {
+        for (Move& move : data.moves) {
+            board.makeMove(move);
+            board.unMakeMove(move);
+        }
+        return static_cast<long>(data.moves.size());
+    }});
+
+    // The en passant square after the move is worked out as makeMove does
+    list.push_back({"updateHash", [](ChessBoard& board, PositionData& data) {
+        uint64_t start = board.snapshot().position.hash;
+        uint64_t result = 0;
+        for (Move& move : data.moves) {
+            uint64_t hash = start;
+            bool pawnMove = move.piece == WHITE_PAWN || move.piece == BLACK_PAWN;
+            int enPassantAfter = pawnMove && (move.from ^ move.to) == 16 ? (move.from + move.to) / 2 : -1;
+            result ^= ZOBRIST.updateHash(hash, move, board.castlingRights, board.enPassant, enPassantAfter);
+        }
+        sink += result;
+        return static_cast<long>(data.moves.size());
+    }});
+
+    // The copy of the unordered list is part of the operation (a copy without allocation)
+    list.push_back({"moveOrdering", [](ChessBoard& board, PositionData& data) {
+        static std::vector<Move> moves;
+        moves.assign(data.moves.begin(), data.moves.end());
+        board.moveOrdering(&moves);
+        sink += moves.front().to;
+        return 1L;
+    }});
+
+    list.push_back({"evaluatePawnPower", [](ChessBoard& board, PositionData&) {
+        sink += board.evaluatePawnPower();
+        return 1L;
+    }});
+    return list;
+}
+
+// Time of repeat passes on every position, in seconds
+static double trial(ChessBoard& board, std::vector<PositionData>& positions, const Primitive& primitive, long repeat, long& ops) {
+    double seconds = 0;
+    ops = 0;
+    for (PositionData& data : positions) {
+        bool whiteToMove;
+        board.loadFen(data.fen, whiteToMove);
+        auto start = std::chrono::steady_clock::now();
+        for (long r = 0; r < repeat; ++r)
+            ops += primitive.pass(board, data);
+        seconds += secondsSince(start);
+    }
+    return seconds;
+}
+
+int main(int argc, char** argv) {
+    int trials = std::max(1, argc > 1 ? std::stoi(argv[1]) : 5);
+    std::string filter = argc > 2 ? argv[2] : "";
+    for (CpuLevel level : {CPU_GENERIC, CPU_POPCNT, CPU_BMI2})
+        if (argc > 3 && std::string(argv[3]) == cpuLevelName(level))
+            setCpuLevel(level);
+
+    sf::RenderWindow window; // Never opened
+    std::unique_ptr<ChessBoard> board = std::make_unique<ChessBoard>(800, 800, 8, window);
+    if (argc > 4 && !board->loadNetwork(argv[4]))
+        return 1;
+
+    std::vector<PositionData> positions(POSITION_COUNT);
+    for (int i = 0; i < POSITION_COUNT; ++i) {
+        PositionData& data = positions[i];
+        data.fen = POSITIONS[i];
+        board->loadFen(data.fen, data.whiteToMove);
+        for (int type = 0; type < 12; ++type)
+            data.squares[type] = board->getPositionsPiece(board->piece.bitboards[type]);
+        data.moves = data.whiteToMove ? board->allMovesForWhite() : board->allMovesForBlack();
+    }
+
+    std::cout << "CPU : " << cpuLevelName(cpuLevel) << " (supported : " << cpuLevelName(cpuSupportedLevel()) << "), "
+              << POSITION_COUNT << " positions, " << trials << " trials" << std::endl;
+    std::cout << std::left << std::setw(24) << "primitive" << std::right << std::setw(12) << "ops/trial"
+              << std::setw(12) << "ns/op" << std::setw(12) << "median" << std::setw(14) << "Mops/s" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+
+    for (const Primitive& primitive : primitives()) {
+        if (primitive.name.find(filter) == std::string::npos)
+            continue;
+
+        // Warm-up : the repeat count doubles until a trial is long enough to be timed
+        long repeat = 1;
+        long ops = 0;
+        while (trial(*board, positions, primitive, repeat, ops) < MIN_TRIAL_SECONDS && ops > 0)
+            repeat *= 2;
+        if (ops == 0) {
+            std::cout << std::left << std::setw(24) << primitive.name << std::right << std::setw(12) << 0 << std::endl;
+            continue;
+        }
+
+        std::vector<double> nsPerOp;
+        for (int t = 0; t < trials; ++t) {
+            double seconds = trial(*board, positions, primitive, repeat, ops);
+            nsPerOp.push_back(seconds * 1e9 / ops);
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+
+        std::cout << std::left << std::setw(24) << primitive.name << std::right << std::setw(12) << ops
+                  << std::setw(12) << nsPerOp.front() << std::setw(12) << nsPerOp[nsPerOp.size() / 2]
+                  << std::setw(14) << 1e3 / nsPerOp.front() << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,528 @@
+// Texel tuning of the classical evaluation (Evaluation.h, PawnStructure.h, Attacks.h, Material.h).
+//
+// Data : one position per line, a FEN followed by the result for White,
+// "[1.0]" / "[0.5]" / "[0.0]" or "1-0" / "1/2-1/2" / "0-1".
+// Usage : tuner <data file> [epochs] [threads]
+//
+// Each position is resolved once by a quiescence search with the engine's evaluation, the terms of the
+// quiet leaf are read with an EvalTrace. The evaluation is linear in its weights :
+// eval = phase * sum(c * mg) + (1 - phase) * scale * sum(c * eg), so the epochs only go through these coefficients.
+// Known endgames (Material.h) don't come from the terms and are left out.
+
+#include "Headers/chessboard.h"
+#include <SFML/Graphics.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+constexpr int BATCH_SIZE = 16384;
+constexpr double LEARNING_RATE = 1.0; // Centipawns
+constexpr double ADAM_BETA1 = 0.9;
+constexpr double ADAM_BETA2 = 0.999;
+constexpr double ADAM_EPSILON = 1e-8;
+
+struct Feature {
+    uint16_t param;
+    int16_t coefficient; // White - Black
+};
+
+struct Sample {
+    uint32_t firstFeature;
+    uint16_t featureCount;
+    float phase;  // Middlegame part, 1 = all the pieces on the board
+    float scale;  // Of the endgame part, 1 = not scaled
+    float result; // 1 white wins, 0.5 draw, 0 black wins
+};
+
+struct TuningData {
+    std::vector<Sample> samples;
+    std::vector<Feature> features;
+};
+
+// Parameters of the tuning, same layout as EvalParam
+struct Weights {
+    double mg[PARAM_COUNT];
+    double eg[PARAM_COUNT];
+};
+
+
+// ════════════════════════════════════════════════════════
+// PARAMETERS
+// ════════════════════════════════════════════════════════
+
+static void initialWeights(Weights& weights) {
+    for (int i = 0; i < PARAM_COUNT; ++i)
+        weights.mg[i] = weights.eg[i] = 0.0;
+
+    for (int type = 0; type < 6; ++type) {
+        weights.mg[PARAM_MATERIAL + type] = MG_VALUE[type];
+        weights.eg[PARAM_MATERIAL + type] = EG_VALUE[type];
+        weights.mg[PARAM_MOBILITY + type] = MOBILITY_MG[type];
+        weights.eg[PARAM_MOBILITY + type] = MOBILITY_EG[type];
+        weights.mg[PARAM_KING_ZONE_ATTACK + type] = KING_ZONE_ATTACK[type];
+        for (int square = 0; square < 64; ++square) {
+            weights.mg[PARAM_PST + type * 64 + square] = MG_TABLE[type][square];
+            weights.eg[PARAM_PST + type * 64 + square] = EG_TABLE[type][square];
+        }
+    }
+
+    weights.mg[PARAM_DOUBLED_PAWN] = DOUBLED_PAWN_MG;
+    weights.eg[PARAM_DOUBLED_PAWN] = DOUBLED_PAWN_EG;
+    weights.mg[PARAM_ISOLATED_PAWN] = ISOLATED_PAWN_MG;
+    weights.eg[PARAM_ISOLATED_PAWN] = ISOLATED_PAWN_EG;
+    weights.mg[PARAM_BACKWARD_PAWN] = BACKWARD_PAWN_MG;
+    weights.eg[PARAM_BACKWARD_PAWN] = BACKWARD_PAWN_EG;
+    for (int rank = 0; rank < 8; ++rank) {
+        weights.mg[PARAM_PASSED_PAWN + rank] = PASSED_PAWN_MG[rank];
+        weights.eg[PARAM_PASSED_PAWN + rank] = PASSED_PAWN_EG[rank];
+    }
+    weights.mg[PARAM_HANGING_PIECE] = HANGING_PIECE_MG;
+    weights.eg[PARAM_HANGING_PIECE] = HANGING_PIECE_EG;
+    weights.mg[PARAM_PAWN_THREAT] = PAWN_THREAT_MG;
+    weights.eg[PARAM_PAWN_THREAT] = PAWN_THREAT_EG;
+    weights.mg[PARAM_BISHOP_PAIR] = BISHOP_PAIR_MG;
+    weights.eg[PARAM_BISHOP_PAIR] = BISHOP_PAIR_EG;
+    weights.mg[PARAM_KNIGHT_PAWNS] = KNIGHT_PAWNS_MG;
+    weights.eg[PARAM_KNIGHT_PAWNS] = KNIGHT_PAWNS_EG;
+    weights.mg[PARAM_ROOK_PAWNS] = ROOK_PAWNS_MG;
+    weights.eg[PARAM_ROOK_PAWNS] = ROOK_PAWNS_EG;
+}
+
+// Endgame weights that don't exist in the evaluation stay at 0
+static bool isMiddlegameOnly(int param) {
+    return param >= PARAM_KING_ZONE_ATTACK && param < PARAM_KING_ZONE_ATTACK + 6;
+}
+
+static void printArray(const char* name, const double* values, int size) {
+    std::cout << "constexpr int " << name << "[" << size << "] = {";
+    for (int i = 0; i < size; ++i)
+        std::cout << static_cast<int>(std::lround(values[i])) << (i + 1 < size ? ", " : "");
+    std::cout << "};\n";
+}
+
+static void printTable(const char* name, const double* values) {
+    std::cout << "constexpr int " << name << "[6][64] = {\n";
+    for (int type = 0; type < 6; ++type) {
+        std::cout << "    {\n";
+        for (int square = 0; square < 64; ++square) {
+            if (square % 8 == 0)
+                std::cout << "       ";
+            std::cout << " " << static_cast<int>(std::lround(values[PARAM_PST + type * 64 + square]));
+            if (square < 63)
+                std::cout << ",";
+            if (square % 8 == 7)
+                std::cout << "\n";
+        }
+        std::cout << (type < 5 ? "    },\n" : "    }\n");
+    }
+    std::cout << "};\n";
+}
+
+// Printed like the constants of the headers, to be copied back
+static void printWeights(const Weights& weights) {
+    std::cout << "\n// Evaluation.h\n";
+    printArray("MG_VALUE", weights.mg + PARAM_MATERIAL, 6);
+    printArray("EG_VALUE", weights.eg + PARAM_MATERIAL, 6);
+    printTable("MG_TABLE", weights.mg);
+    printTable("EG_TABLE", weights.eg);
+
+    std::cout << "\n// PawnStructure.h\n";
+    const char* pawnNames[3] = {"DOUBLED_PAWN", "ISOLATED_PAWN", "BACKWARD_PAWN"};
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "constexpr int " << pawnNames[i] << "_MG = " << std::lround(weights.mg[PARAM_DOUBLED_PAWN + i]) << ";\n";
+        std::cout << "constexpr int " << pawnNames[i] << "_EG = " << std::lround(weights.eg[PARAM_DOUBLED_PAWN + i]) << ";\n";
+    }
+    printArray("PASSED_PAWN_MG", weights.mg + PARAM_PASSED_PAWN, 8);
+    printArray("PASSED_PAWN_EG", weights.eg + PARAM_PASSED_PAWN, 8);
+
+    std::cout << "\n// Attacks.h\n";
+    printArray("MOBILITY_MG", weights.mg + PARAM_MOBILITY, 6);
+    printArray("MOBILITY_EG", weights.eg + PARAM_MOBILITY, 6);
+    printArray("KING_ZONE_ATTACK", weights.mg + PARAM_KING_ZONE_ATTACK, 6);
+    std::cout << "constexpr int HANGING_PIECE_MG = " << std::lround(weights.mg[PARAM_HANGING_PIECE]) << ";\n";
+    std::cout << "constexpr int HANGING_PIECE_EG = " << std::lround(weights.eg[PARAM_HANGING_PIECE]) << ";\n";
+    std::cout << "constexpr int PAWN_THREAT_MG = " << std::lround(weights.mg[PARAM_PAWN_THREAT]) << ";\n";
+    std::cout << "constexpr int PAWN_THREAT_EG = " << std::lround(weights.eg[PARAM_PAWN_THREAT]) << ";\n";
+
+    std::cout << "\n// Material.h\n";
+    const char* materialNames[3] = {"BISHOP_PAIR", "KNIGHT_PAWNS", "ROOK_PAWNS"};
+    for (int i = 0; i < 3; ++i) {
+        std::cout << "constexpr int " << materialNames[i] << "_MG = " << std::lround(weights.mg[PARAM_BISHOP_PAIR + i]) << ";\n";
+        std::cout << "constexpr int " << materialNames[i] << "_EG = " << std::lround(weights.eg[PARAM_BISHOP_PAIR + i]) << ";\n";
+    }
+}
+
+
+// ════════════════════════════════════════════════════════
+// LOADING
+// ════════════════════════════════════════════════════════
+
+static bool parseResult(const std::string& line, float& result) {
+    size_t bracket = line.find('[');
+    if (bracket != std::string::npos) {
+        result = std::stof(line.substr(bracket + 1));
+        return true;
+    }
+    if (line.find("1/2-1/2") != std::string::npos)
+        result = 0.5f;
+    else if (line.find("1-0") != std::string::npos)
+        result = 1.0f;
+    else if (line.find("0-1") != std::string::npos)
+        result = 0.0f;
+    else
+        return false;
+    return true;
+}
+
+// One thread : lines [begin, end) go to data, the evaluations that the weights don't give back are counted
+static void loadRange(const std::vector<std::string>& lines, size_t begin, size_t end, const Weights& weights,
+                      TuningData& data, int& skipped, int& mismatches) {
+    sf::RenderWindow window; // Never opened
+    std::unique_ptr<ChessBoard> board = std::make_unique<ChessBoard>(800, 800, 8, window);
+    Piece leaf;
+
+    for (size_t i = begin; i < end; ++i) {
+        float result;
+        bool whiteToMove;
+        if (!parseResult(lines[i], result) || !board->loadFen(lines[i], whiteToMove)) {
+            skipped++;
+            continue;
+        }
+
+        // The engine's quiescence (evasions when in check), the weights are fitted on the quiet position it ends in
+        board->quiescence(whiteToMove, -INFINITE_SCORE, INFINITE_SCORE, &leaf);
+        board->piece = leaf;
+
+        EvalTrace trace;
+        int eval = board->evaluate(&trace);
+        int phase = std::min(board->computeEvalState().phase, PHASE_MAX);
+        if (trace.specialised) {
+            skipped++;
+            continue;
+        }
+
+        Sample sample;
+        sample.firstFeature = static_cast<uint32_t>(data.features.size());
+        sample.phase = static_cast<float>(phase) / PHASE_MAX;
+        sample.scale = static_cast<float>(trace.scale) / SCALE_NORMAL;
+        sample.result = result;
+
+        double mg = 0.0, eg = 0.0;
+        for (int param = 0; param < PARAM_COUNT; ++param) {
+            if (trace.coefficients[param] == 0)
+                continue;
+            data.features.push_back({static_cast<uint16_t>(param), static_cast<int16_t>(trace.coefficients[param])});
+            mg += trace.coefficients[param] * weights.mg[param];
+            eg += trace.coefficients[param] * weights.eg[param];
+        }
+        sample.featureCount = static_cast<uint16_t>(data.features.size() - sample.firstFeature);
+        data.samples.push_back(sample);
+
+        // The engine rounds the scaled endgame part and the tapered score down
+        if (std::abs((mg * phase + eg * sample.scale * (PHASE_MAX - phase)) / PHASE_MAX - eval) > 2.0)
+            mismatches++;
+    }
+}
+
+static bool loadData(const std::string& path, int threadCount, const Weights& weights, TuningData& data) {
+    std::ifstream file(path);
+    if (!file) {
+        std::cerr << "Tuner: unable to open " << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line))
+        if (!line.empty())
+            lines.push_back(line);
+
+    std::vector<TuningData> parts(threadCount);
+    std::vector<int> skipped(threadCount, 0);
+    std::vector<int> mismatches(threadCount, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; ++t) {
+        size_t begin = lines.size() * t / threadCount;
+        size_t end = lines.size() * (t + 1) / threadCount;
+        threads.emplace_back(loadRange, std::cref(lines), begin, end, std::cref(weights),
+                             std::ref(parts[t]), std::ref(skipped[t]), std::ref(mismatches[t]));
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    int totalSkipped = 0, totalMismatches = 0;
+    for (int t = 0; t < threadCount; ++t) {
+        uint32_t offset = static_cast<uint32_t>(data.features.size());
+        for (Sample sample : parts[t].samples) {
+            sample.firstFeature += offset;
+            data.samples.push_back(sample);
+        }
+        data.features.insert(data.features.end(), parts[t].features.begin(), parts[t].features.end());
+        totalSkipped += skipped[t];
+        totalMismatches += mismatches[t];
+    }
+
+    // The lines of a game follow each other : the batches are better mixed
+    std::vector<Feature> shuffled;
+    shuffled.reserve(data.features.size());
+    std::shuffle(data.samples.begin(), data.samples.end(), std::mt19937(0));
+    for (Sample& sample : data.samples) {
+        uint32_t first = static_cast<uint32_t>(shuffled.size());
+        shuffled.insert(shuffled.end(), data.features.begin() + sample.firstFeature,
+                        data.features.begin() + sample.firstFeature + sample.featureCount);
+        sample.firstFeature = first;
+    }
+    data.features.swap(shuffled);
+
+    std::cout << "Positions : " << data.samples.size() << " (" << totalSkipped << " lines skipped)" << std::endl;
+    if (totalMismatches > 0)
+        std::cerr << "Tuner: " << totalMismatches << " evaluations don't match the trace, a term is missing in EvalTrace" << std::endl;
+    return !data.samples.empty();
+}
+
+
+// ════════════════════════════════════════════════════════
+// TUNING
+// ════════════════════════════════════════════════════════
+
+static inline double sigmoid(double K, double eval) {
+    return 1.0 / (1.0 + std::pow(10.0, -K * eval / 400.0));
+}
+
+static inline double linearEval(const TuningData& data, const Sample& sample, const Weights& weights) {
+    double mg = 0.0, eg = 0.0;
+    const Feature* feature = &data.features[sample.firstFeature];
+    for (int i = 0; i < sample.featureCount; ++i, ++feature) {
+        mg += feature->coefficient * weights.mg[feature->param];
+        eg += feature->coefficient * weights.eg[feature->param];
+    }
+    return mg * sample.phase + eg * (1.0 - sample.phase) * sample.scale;
+}
+
+enum Job { COMPUTE_ERROR, COMPUTE_GRADIENT };
+
+// The threads are started once, each run() splits [begin, end) between them.
+// Nothing is allocated while the epochs go.
+class WorkerPool {
+    public:
+        WorkerPool(int threadCount, const TuningData& data, const Weights& weights)
+            : data(data), weights(weights), gradients(threadCount), errors(threadCount) {
+            for (int t = 0; t < threadCount; ++t)
+                threads.emplace_back(&WorkerPool::work, this, t);
+        }
+
+        ~WorkerPool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stop = true;
+                generation++;
+            }
+            start.notify_all();
+            for (std::thread& thread : threads)
+                thread.join();
+        }
+
+        // Sum of the squared errors of [begin, end)
+        double error(double K, size_t begin, size_t end) {
+            run(COMPUTE_ERROR, K, begin, end);
+            double sum = 0.0;
+            for (const Padded& e : errors)
+                sum += e.value;
+            return sum;
+        }
+
+        // Gradient of the squared errors of [begin, end), added over the threads
+        void gradient(double K, size_t begin, size_t end, Weights& result) {
+            run(COMPUTE_GRADIENT, K, begin, end);
+            for (int i = 0; i < PARAM_COUNT; ++i) {
+                result.mg[i] = result.eg[i] = 0.0;
+                for (const Weights& g : gradients) {
+                    result.mg[i] += g.mg[i];
+                    result.eg[i] += g.eg[i];
+                }
+            }
+        }
+
+    private:
+        struct alignas(64) Padded {
+            double value = 0.0;
+        };
+
+        const TuningData& data;
+        const Weights& weights;
+        std::vector<Weights> gradients; // One per thread
+        std::vector<Padded> errors;
+        std::vector<std::thread> threads;
+
+        std::mutex mutex;
+        std::condition_variable start;
+        std::condition_variable done;
+        int generation = 0;
+        int pending = 0;
+        bool stop = false;
+
+        Job job = COMPUTE_ERROR;
+        double K = 1.0;
+        size_t begin = 0;
+        size_t end = 0;
+
+        void run(Job newJob, double newK, size_t newBegin, size_t newEnd) {
+            std::unique_lock<std::mutex> lock(mutex);
+            job = newJob;
+            K = newK;
+            begin = newBegin;
+            end = newEnd;
+            pending = static_cast<int>(threads.size());
+            generation++;
+            start.notify_all();
+            done.wait(lock, [this] { return pending == 0; });
+        }
+
+        void work(int id) {
+            int seen = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    start.wait(lock, [&] { return generation != seen; });
+                    seen = generation;
+                    if (stop)
+                        return;
+                }
+
+                size_t count = end - begin;
+                size_t first = begin + count * id / threads.size();
+                size_t last = begin + count * (id + 1) / threads.size();
+                if (job == COMPUTE_ERROR)
+                    errors[id].value = errorRange(first, last);
+                else
+                    gradientRange(first, last, gradients[id]);
+
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0)
+                    done.notify_one();
+            }
+        }
+
+        double errorRange(size_t first, size_t last) const {
+            double sum = 0.0;
+            for (size_t i = first; i < last; ++i) {
+                const Sample& sample = data.samples[i];
+                double difference = sample.result - sigmoid(K, linearEval(data, sample, weights));
+                sum += difference * difference;
+            }
+            return sum;
+        }
+
+        // d(r - s)^2 / dw = -2 (r - s) s (1 - s) K ln(10) / 400 * c * phase (or (1 - phase) * scale)
+        void gradientRange(size_t first, size_t last, Weights& gradient) const {
+            for (int i = 0; i < PARAM_COUNT; ++i)
+                gradient.mg[i] = gradient.eg[i] = 0.0;
+
+            for (size_t i = first; i < last; ++i) {
+                const Sample& sample = data.samples[i];
+                double s = sigmoid(K, linearEval(data, sample, weights));
+                double factor = -2.0 * (sample.result - s) * s * (1.0 - s) * K * std::log(10.0) / 400.0;
+                double mgFactor = factor * sample.phase;
+                double egFactor = factor * (1.0 - sample.phase) * sample.scale;
+
+                const Feature* feature = &data.features[sample.firstFeature];
+                for (int f = 0; f < sample.featureCount; ++f, ++feature) {
+                    gradient.mg[feature->param] += mgFactor * feature->coefficient;
+                    gradient.eg[feature->param] += egFactor * feature->coefficient;
+                }
+            }
+        }
+};
+
+// Scaling of the sigmoid that fits the current weights best : ternary search
+static double findK(WorkerPool& pool, size_t count) {
+    double low = 0.1, high = 3.0;
+    for (int i = 0; i < 40; ++i) {
+        double k1 = low + (high - low) / 3.0;
+        double k2 = high - (high - low) / 3.0;
+        if (pool.error(k1, 0, count) < pool.error(k2, 0, count))
+            high = k2;
+        else
+            low = k1;
+    }
+    return (low + high) / 2.0;
+}
+
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        std::cerr << "Usage : tuner <data file> [epochs] [threads]" << std::endl;
+        return 1;
+    }
+    int epochs = argc > 2 ? std::stoi(argv[2]) : 100;
+    int threadCount = argc > 3 ? std::stoi(argv[3]) : static_cast<int>(std::thread::hardware_concurrency());
+    threadCount = std::max(threadCount, 1);
+
+    std::unique_ptr<Weights> weights = std::make_unique<Weights>();
+    initialWeights(*weights);
+
+    auto loadStart = std::chrono::steady_clock::now();
+    TuningData data;
+    if (!loadData(argv[1], threadCount, *weights, data))
+        return 1;
+    std::chrono::duration<double> loadTime = std::chrono::steady_clock::now() - loadStart;
+    std::cout << "Loaded in " << loadTime.count() << " s with " << threadCount << " threads" << std::endl;
+
+    size_t count = data.samples.size();
+    WorkerPool pool(threadCount, data, *weights);
+
+    double K = findK(pool, count);
+    std::cout << "K = " << K << ", error = " << pool.error(K, 0, count) / count << std::endl;
+
+    // Adam, one step per batch
+    std::unique_ptr<Weights> gradient = std::make_unique<Weights>();
+    std::unique_ptr<Weights> moment1 = std::make_unique<Weights>();
+    std::unique_ptr<Weights> moment2 = std::make_unique<Weights>();
+    *moment1 = Weights();
+    *moment2 = Weights();
+    int step = 0;
+
+    for (int epoch = 1; epoch <= epochs; ++epoch) {
+        auto epochStart = std::chrono::steady_clock::now();
+
+        for (size_t batch = 0; batch < count; batch += BATCH_SIZE) {
+            size_t batchEnd = std::min(batch + BATCH_SIZE, count);
+            pool.gradient(K, batch, batchEnd, *gradient);
+            step++;
+
+            double correction1 = 1.0 - std::pow(ADAM_BETA1, step);
+            double correction2 = 1.0 - std::pow(ADAM_BETA2, step);
+            double scale = 1.0 / (batchEnd - batch);
+
+            for (int i = 0; i < PARAM_COUNT; ++i) {
+                double g = gradient->mg[i] * scale;
+                moment1->mg[i] = ADAM_BETA1 * moment1->mg[i] + (1.0 - ADAM_BETA1) * g;
+                moment2->mg[i] = ADAM_BETA2 * moment2->mg[i] + (1.0 - ADAM_BETA2) * g * g;
+                weights->mg[i] -= LEARNING_RATE * (moment1->mg[i] / correction1) / (std::sqrt(moment2->mg[i] / correction2) + ADAM_EPSILON);
+
+                if (isMiddlegameOnly(i))
+                    continue;
+                g = gradient->eg[i] * scale;
+                moment1->eg[i] = ADAM_BETA1 * moment1->eg[i] + (1.0 - ADAM_BETA1) * g;
+                moment2->eg[i] = ADAM_BETA2 * moment2->eg[i] + (1.0 - ADAM_BETA2) * g * g;
+                weights->eg[i] -= LEARNING_RATE * (moment1->eg[i] / correction1) / (std::sqrt(moment2->eg[i] / correction2) + ADAM_EPSILON);
+            }
+        }
+
+        std::chrono::duration<double> epochTime = std::chrono::steady_clock::now() - epochStart;
+        std::cout << "Epoch " << epoch << " : error = " << pool.error(K, 0, count) / count
+                  << " (" << epochTime.count() << " s)" << std::endl;
+    }
+
+    printWeights(*weights);
+    return 0;
+}